@@ -1,9 +1,22 @@
+const colorHandles = {};
+
 const Led = {
+    color: (color) => {
+        if (!(color in colorHandles)) {
+            colorHandles[color] = run('return', 'led', 'color', color).trim();
+        }
+        return colorHandles[color];
+    },
     setPixel: (ledString, ledIndex, color) => {
         run('led', 'set-pixel', ledString, ledIndex, color);
     },
-    animate: (ledString, delay, pixelDelay, pixelDuration, color, halfCycles, blending, easing) => {
-        if (halfCycles !== undefined) {
+    animate: (ledString, delay, pixelDelay, pixelDuration, color, halfCycles, blending, easing, layer) => {
+        if (layer !== undefined) {
+            run(
+                'led', 'animate',
+                ledString, delay, pixelDelay, pixelDuration, color, halfCycles, blending, easing, layer
+            );
+        } else if (halfCycles !== undefined) {
             run(
                 'led', 'animate',
                 ledString, delay, pixelDelay, pixelDuration, color, halfCycles, blending, easing
@@ -15,11 +28,16 @@ const Led = {
             );
         }
     },
-    animate3D: (ledString, coordType, startPos, delay, pixelDelay, pixelDuration, range, color, halfCycles, blending, easing) => {
+    animate3D: (ledString, coordType, startPos, delay, pixelDelay, pixelDuration, range, color, halfCycles, blending, easing, layer) => {
         if (typeof startPos === "object") {
             startPos = `[${startPos[0]},${startPos[1]},${startPos[2]}]`;
         }
-        if (halfCycles !== undefined) {
+        if (layer !== undefined) {
+            run(
+                'led', 'animate-3d',
+                ledString, coordType, startPos, delay, pixelDelay, pixelDuration, range, color, halfCycles, blending, easing, layer
+            );
+        } else if (halfCycles !== undefined) {
             run(
                 'led', 'animate-3d',
                 ledString, coordType, startPos, delay, pixelDelay, pixelDuration, range, color, halfCycles, blending, easing
@@ -20,6 +20,7 @@
 
 #include <Js.h>
 #include <LedView.h>
+#include <Esp32Cli/BinaryCommand.h>
 #include <Esp32Cli/Command.h>
 #include <Esp32Cli/CommandGroup.h>
 
@@ -35,11 +36,28 @@ protected:
 
     void enableManualMode(const std::shared_ptr<Esp32Cli::Client>& client);
 
-    static std::tuple<float, float, float> parsePosition(std::string positionStr);
+    static std::tuple<float, float, float> parsePosition(const char* positionStr);
 
     std::shared_ptr<LedManager> m_ledManager;
 };
 
+/**
+ * LED command working on an @link Esp32Cli::ArgvView, see @link Esp32Cli::ArgvCommand.
+ */
+class LedArgvCommand : public LedCommand {
+public:
+    explicit LedArgvCommand(const std::shared_ptr<LedManager>& ledManager) : LedCommand(ledManager) {
+    }
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv,
+                 const std::shared_ptr<Esp32Cli::Client>& client) const override = 0;
+
+    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+                 const std::shared_ptr<Esp32Cli::Client>& client) const final {
+        executeArgvView(io, commandName, argv, client);
+    }
+};
+
 class LsCommand : public LedCommand {
 public:
     explicit LsCommand(const std::shared_ptr<LedManager>& ledManager) : LedCommand(
@@ -139,15 +157,52 @@ public:
     }
 };
 
-class SetPixelCommand : public LedCommand {
+class MasterBrightnessCommand : public LedCommand {
 public:
-    explicit SetPixelCommand(const std::shared_ptr<LedManager>& ledManager) : LedCommand(
-        ledManager) {
+    explicit MasterBrightnessCommand(const std::shared_ptr<LedManager>& ledManager) : LedCommand(ledManager) {
     }
 
     void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
                  const std::shared_ptr<Esp32Cli::Client>& client) const override;
 
+    void printUsage(Print& output) const override {
+        output.println("[<brightness>]");
+    }
+
+    void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
+        output.println("Print or set the brightness all LED strings are scaled with");
+    }
+};
+
+class ColorCommand : public LedCommand {
+public:
+    explicit ColorCommand(const std::shared_ptr<LedManager>& ledManager) : LedCommand(ledManager) {
+    }
+
+    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+                 const std::shared_ptr<Esp32Cli::Client>& client) const override;
+
+    void printUsage(Print& output) const override {
+        output.println("<color>");
+    }
+
+    void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
+        output.println("Parse a color once and print a handle (\"@<n>\") that can be used in place of the color");
+        output.println("Prints the color itself if no more handles are available");
+    }
+};
+
+class SetPixelCommand : public LedArgvCommand {
+public:
+    explicit SetPixelCommand(const std::shared_ptr<LedManager>& ledManager) : LedArgvCommand(
+        ledManager) {
+    }
+
+    using LedArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv,
+                 const std::shared_ptr<Esp32Cli::Client>& client) const override;
+
     void printUsage(Print& output) const override {
         output.println("<name> <index> <color>");
     }
@@ -157,12 +212,14 @@ public:
     }
 };
 
-class AnimatePixelCommand : public LedCommand {
+class AnimatePixelCommand : public LedArgvCommand {
 public:
-    explicit AnimatePixelCommand(const std::shared_ptr<LedManager>& ledManager) : LedCommand(ledManager) {
+    explicit AnimatePixelCommand(const std::shared_ptr<LedManager>& ledManager) : LedArgvCommand(ledManager) {
     }
 
-    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+    using LedArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv,
                  const std::shared_ptr<Esp32Cli::Client>& client) const override;
 
     void printUsage(Print& output) const override {
@@ -174,35 +231,41 @@ public:
     }
 };
 
-class AnimateCommand : public LedCommand {
+class AnimateCommand : public LedArgvCommand {
 public:
-    explicit AnimateCommand(const std::shared_ptr<LedManager>& ledManager) : LedCommand(
+    explicit AnimateCommand(const std::shared_ptr<LedManager>& ledManager) : LedArgvCommand(
         ledManager) {
     }
 
-    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+    using LedArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv,
                  const std::shared_ptr<Esp32Cli::Client>& client) const override;
 
     void printUsage(Print& output) const override {
-        output.println("<name> <delay> <pixel_delay> <duration> <color> [<half_cycles> <blending> <easing>]");
+        output.println(
+            "<name> <delay> <pixel_delay> <duration> <color> [<half_cycles> <blending> <easing> [<layer>]]");
     }
 
     void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
         output.println("Animate a string of LEDs");
+        output.println("Layers are base, blend1, blend2, overlay and auto. Higher layers are drawn over lower ones.");
     }
 };
 
-class Animate3DCommand : public LedCommand {
+class Animate3DCommand : public LedArgvCommand {
 public:
-    explicit Animate3DCommand(const std::shared_ptr<LedManager>& ledManager) : LedCommand(ledManager) {
+    explicit Animate3DCommand(const std::shared_ptr<LedManager>& ledManager) : LedArgvCommand(ledManager) {
     }
 
-    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+    using LedArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv,
                  const std::shared_ptr<Esp32Cli::Client>& client) const override;
 
     void printUsage(Print& output) const override {
         output.println(
-            "<name> <local|global> \"<x>,<y>,<z>\" <delay> <pixel_delay> <duration> <range> <color> [<half_cycles> <blending> <easing>]");
+            "<name> <local|global> \"<x>,<y>,<z>\" <delay> <pixel_delay> <duration> <range> <color> [<half_cycles> <blending> <easing> [<layer>]]");
     }
 
     void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
@@ -303,6 +366,46 @@ private:
     std::shared_ptr<Js> m_js;
 };
 
+/**
+ * Binary counterpart of @link AnimateCommand and @link Animate3DCommand for clients sending many animations.
+ *
+ * Payload (little endian, 42 bytes):
+ * - uint16 view id: Index of the view as listed by "led ls"
+ * - uint8 flags: @link Flags
+ * - uint8 easing: Index of the easing function
+ * - uint8 blending: 0 blend, 1 add
+ * - uint8 layer: @link Led::Layer, a layer below @link Led::LayerCount or @link Led::Layer::Auto
+ * - int8 half cycles
+ * - uint8 reserved
+ * - uint16 start delay, LED delay min/max, LED duration min/max: In centiseconds
+ * - float x, y, z, range: Wave start position and range, only for @link Flags::Wave3D
+ * - uint16 r, g, b: 0-65535, or for @link Flags::ColorHandle the color handle in r
+ * - uint8 w
+ * - uint8 brightness: 255 = 1.0
+ */
+class AnimateBinaryCommand : public Esp32Cli::BinaryCommand {
+public:
+    static constexpr uint8_t Type = 0x01;
+
+    enum Flags : uint8_t {
+        Wave3D = 0x01,
+        GlobalPosition = 0x02,
+        ColorHandle = 0x04,
+        LedDelayIsTotal = 0x08,
+        LedDelayIsGlobal = 0x10,
+        LedDurationIsTotal = 0x20,
+    };
+
+    explicit AnimateBinaryCommand(std::shared_ptr<LedManager> ledManager) : m_ledManager{std::move(ledManager)} {
+    }
+
+    void execute(Stream& io, const uint8_t* payload, size_t size,
+                 const std::shared_ptr<Esp32Cli::Client>& client) const override;
+
+private:
+    std::shared_ptr<LedManager> m_ledManager;
+};
+
 class LedCommandGroup : public Esp32Cli::CommandGroup {
 public:
     explicit LedCommandGroup(const std::shared_ptr<LedManager>& ledManager, const std::shared_ptr<Js>& js);
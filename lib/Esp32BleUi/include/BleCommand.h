@@ -0,0 +1,33 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Esp32Cli/CommandGroup.h>
+
+class Esp32BleUi;
+
+namespace Esp32BleUiCommands {
+/**
+ * Settings of the BLE connection of the client running the command.
+ */
+class BleCommand : public Esp32Cli::CommandGroup {
+public:
+    explicit BleCommand(Esp32BleUi& bleUi);
+};
+}
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <Esp32Cli.h>
 #include <esp_task_wdt.h>
@@ -30,23 +31,184 @@
 
 class Esp32BleUi : public NimBLECharacteristicCallbacks, public NimBLEServerCallbacks {
 public:
+    /**
+     * Connection parameters chosen per connection by its workload, the highest profile of all connections is reported
+     * as the metric Ble/Profile.
+     */
+    enum class ConnectionProfile : uint8_t {
+        /**
+         * Long connection interval with peripheral latency after a period without CLI input or output.
+         */
+        Idle,
+        Interactive,
+        /**
+         * Shortest connection interval and the 2M PHY while a bulk transfer command runs.
+         */
+        Bulk,
+    };
+
+    /**
+     * Notifications are scheduled per client by traffic class. Control traffic (RX acknowledges) has strict priority,
+     * the other classes share the bandwidth by their weights, ties go to the lower class.
+     */
+    enum class TrafficClass : uint8_t {
+        Control,
+        /**
+         * CLI output of regular commands.
+         */
+        Interactive,
+        Metrics,
+        /**
+         * CLI output of bulk transfer commands, see @link ConnectionProfile::Bulk.
+         */
+        Bulk,
+    };
+
+    static constexpr size_t TrafficClassCount = 4;
+
+    struct TrafficStats {
+        uint32_t notifications;
+        uint32_t bytes;
+    };
+
     explicit Esp32BleUi(std::shared_ptr<Esp32Cli::Cli> cli);
 
     ~Esp32BleUi() override;
 
     void onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc) override;
 
+    void onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc, uint16_t subValue) override;
+
     void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) override;
 
     void onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) override;
 
+    void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) override;
+
     void setKeyValueStore(std::shared_ptr<KeyValueStore>);
 
+    /**
+     * Switch the metrics of a client between full records and dictionary records, see @link encodeMetric.
+     * @return False if the client is not connected over BLE.
+     */
+    bool setMetricsDictionary(const Esp32Cli::Client& cliClient, bool isEnabled);
+
+    /**
+     * Let a client opt in to credit based RX flow control. Writes exceeding the announced credits then disconnect the
+     * client. Without credits such writes are queued in a bounded overflow buffer and only acknowledged once the RX
+     * buffer has space for them, writes exceeding the overflow buffer are dropped.
+     * @return False if the client is not connected over BLE.
+     */
+    bool setRxCredits(const Esp32Cli::Client& cliClient, bool isEnabled);
+
+    /**
+     * Send all metrics to a client again, in dictionary mode including their names.
+     * @return False if the client is not connected over BLE.
+     */
+    bool requestMetricsResync(const Esp32Cli::Client& cliClient);
+
+    /**
+     * Limit how often changed metrics are sent, updates in between are coalesced.
+     */
+    void setMetricsRate(uint32_t maximumRateHz);
+
+    uint32_t getMetricsRate() const;
+
+    /**
+     * Add a value of the @link KeyValueStore to the state summary in the scan response, in order of the calls as long
+     * as they fit. Advertised values are runtime state and not part of the config hash. See @link updateAdvertisement
+     * for the format.
+     * @return False if there is no value with the given name.
+     */
+    bool addAdvertisedValue(const char* name);
+
+    /**
+     * Set the bandwidth share of a traffic class relative to the others, the weight of @link TrafficClass::Control
+     * is ignored.
+     */
+    void setTrafficWeight(TrafficClass trafficClass, uint8_t weight);
+
+    uint8_t getTrafficWeight(TrafficClass trafficClass) const;
+
+    TrafficStats getTrafficStats(TrafficClass trafficClass) const;
+
+    /**
+     * Number of times the TX task found the NimBLE buffer pool exhausted and polled it again after one tick.
+     */
+    uint32_t getTxBufferPolls() const;
+
+    void resetTrafficStats();
+
 private:
     class Client;
 
+    enum class SendResult {
+        Idle,
+        Sent,
+        OutOfBuffers,
+        Failed,
+    };
+
+    /**
+     * First record of a metric in dictionary mode: [0x01][id: uint8][name][0x00][size: uint8][value]
+     * The id is the index of the value in the @link KeyValueStore.
+     */
+    static constexpr uint8_t MetricDefineRecord = 0x01;
+    /**
+     * Following records of a metric in dictionary mode: [0x02][id: uint8][size: uint8][value]
+     */
+    static constexpr uint8_t MetricValueRecord = 0x02;
+    /**
+     * Values with a higher index in the @link KeyValueStore are tracked in a list instead of the dirty bitset and only
+     * sent to clients not using the metrics dictionary, its ids are a single byte.
+     */
+    static constexpr size_t MaximumMetrics = 256;
+    static constexpr uint32_t DefaultMetricsRateHz = 20;
+    static constexpr uint8_t AdvertisementVersion = 1;
+    /**
+     * Set in the advertisement flags if not all advertised values fit into the scan response.
+     */
+    static constexpr uint8_t AdvertisementValuesTruncated = 0x01;
+    static constexpr uint32_t AdvertisementUpdateIntervalMs = 1000;
+
     void onRxWrite(ble_gap_conn_desc* desc);
 
+    std::shared_ptr<Client> findClient(const Esp32Cli::Client& cliClient);
+
+    std::shared_ptr<Client> findClient(uint16_t connHandle);
+
+    SendResult notify(const Client& client, NimBLECharacteristic* characteristic, const void* data, size_t size);
+
+    /**
+     * Send one notification with the RX acknowledge, TX data or metrics of a client.
+     * @param sentBytes Receives the payload size of the sent notification.
+     */
+    SendResult sendPending(Client& client, size_t* sentBytes);
+
+    /**
+     * Send at most one round of the deficit round-robin scheduler.
+     * @return Whether any client sent data.
+     */
+    bool sendRound(bool* outOfBuffers);
+
+    /**
+     * Bytes a client may send per round, smaller for clients running a bulk transfer so interactive clients get the
+     * larger share of the buffers.
+     */
+    int32_t getTxQuantum(const Client& client) const;
+
+    void countTraffic(TrafficClass trafficClass, size_t bytes);
+
+    /**
+     * Switch the connection profile of clients whose workload changed and update the profile metric.
+     */
+    void updateConnectionProfiles();
+
+    /**
+     * @return False if NimBLE rejected the update, it is retried later then.
+     */
+    bool applyConnectionProfile(Client& client, ConnectionProfile profile);
+
     [[noreturn]] void processTxQueue();
 
     static void runTxQueue(void* arg) {
@@ -55,14 +217,37 @@ private:
 
     [[noreturn]] void processMetrics();
 
-    void processChangedMetricsBuffer();
+    /**
+     * Move changed metrics into the pending metrics of all clients and encode them.
+     * @return Whether any metric changed.
+     */
+    bool flushChangedMetrics();
+
+    /**
+     * Publish the state summary as manufacturer data (company id 0xffff) in the scan response next to the hostname:
+     * [version: uint8][flags: uint8][firmware ELF SHA-256 prefix: 2 bytes][config hash: uint16 LE]
+     * followed by [index: uint8][size: uint8][value] of each advertised value that fits. The index matches the
+     * dictionary id of the metric. The config hash covers all persistent values except the advertised ones, so it
+     * only changes with the configuration and not e.g. with a brightness slider.
+     */
+    void updateAdvertisement();
+
+    /**
+     * Encode the pending metrics of a client into its metrics buffer as far as they fit.
+     */
+    void encodePendingMetrics(Client& client);
+
+    /**
+     * Encode a metric update for a client. Without dictionary mode this is the full record
+     * [name][0x00][size: uint8][value] which never starts with a dictionary record type.
+     */
+    size_t encodeMetric(const Client& client, const KeyValueStore::Value& metric, uint8_t* buffer, size_t bufferSize,
+                        size_t* requiredBufferSize);
 
     static void runMetrics(void* arg) {
         static_cast<Esp32BleUi*>(arg)->processMetrics();
     }
 
-    static void runClient(void* arg);
-
     TaskHandle_t m_metricsTask{nullptr};
     TaskHandle_t m_txTask{nullptr};
     NimBLEServer* m_bleServer{nullptr};
@@ -73,9 +258,34 @@ private:
     NimBLECharacteristic* m_uiCharacteristic;
     std::mutex m_clientsMutex;
     std::vector<std::shared_ptr<Client> > m_clients;
+    /**
+     * Copy of the clients the TX task sends to, so connecting and disconnecting never waits for a send round.
+     */
+    std::vector<std::shared_ptr<Client> > m_txClients;
+    size_t m_txNextClient{0};
     std::shared_ptr<Esp32Cli::Cli> m_cli;
-    std::mutex m_metricsMutex;
     std::shared_ptr<KeyValueStore> m_metrics;
-    LightweightMap<std::shared_ptr<const KeyValueStore::Value>> m_changedMetrics;
-    RingBuffer<uint8_t, 128> m_changedMetricsBuffer;
+    /**
+     * Bit per value index changed since the last flush, set from the value change callback without locking.
+     */
+    std::atomic<uint32_t> m_dirtyMetrics[MaximumMetrics / 32]{};
+    std::atomic<uint32_t> m_metricsFlushIntervalMs{1000 / DefaultMetricsRateHz};
+    std::atomic<bool> m_hasDroppedMetrics{false};
+    /**
+     * Changed values with an index of at least @link MaximumMetrics.
+     */
+    std::mutex m_overflowMetricsMutex;
+    std::vector<std::shared_ptr<const KeyValueStore::Value> > m_overflowMetrics;
+    /**
+     * Set once the @link KeyValueStore is known, the TX task reads it via std::atomic_load.
+     */
+    std::shared_ptr<KeyValueStore::SimpleValue<uint8_t> > m_profileMetric;
+    std::mutex m_advertisementMutex;
+    std::vector<std::shared_ptr<const KeyValueStore::Value> > m_advertisedValues;
+    std::string m_scanResponseManufacturerData;
+    std::atomic<bool> m_isAdvertisementDirty{true};
+    std::atomic<uint8_t> m_trafficWeights[TrafficClassCount]{{0}, {4}, {2}, {1}};
+    std::atomic<uint32_t> m_trafficNotifications[TrafficClassCount]{};
+    std::atomic<uint32_t> m_trafficBytes[TrafficClassCount]{};
+    std::atomic<uint32_t> m_txBufferPolls{0};
 };
@@ -20,6 +20,7 @@
 
 #include "RingBuffer.h"
 
+#include <bitset>
 #include <Esp32Cli/Client.h>
 
 class Esp32BleUi::Client : public Esp32Cli::Client {
@@ -46,15 +47,133 @@ public:
 
     void onCommandEnd() override;
 
+    bool hasPendingInput() override;
+
+protected:
+    size_t borrowInput(const char** data, ExecType execType) override;
+
+    void executeCommand(const Esp32Cli::ArgvView& argv) override;
+
+    void consumeInput(size_t size) override;
+
 private:
-    TaskHandle_t m_txTask;
-    uint16_t m_rxAckPendingBytes{0};
+    /**
+     * Payload size of a notification with the ATT MTU negotiated for this connection.
+     */
+    size_t chunkSize() const {
+        return m_mtu - 3;
+    }
+
+    void notifyTxTask() const;
+
+    /**
+     * Wake up tasks waiting for data or space in the buffers. The buffers are lock free, the mutexes only guard
+     * waiting on the condition variables against lost wake-ups.
+     */
+    void notifyRxGiven();
+
+    /**
+     * Move overflowed writes into the freed RX buffer space and wake up the TX task if the central can be granted more
+     * credits.
+     */
+    void notifyRxTaken();
+
+    /**
+     * Move as much of the RX overflow buffer into the RX buffer as fits and acknowledge the moved bytes. Requires
+     * m_rxOverflowMutex.
+     */
+    void moveRxOverflow();
+
+    /**
+     * @return Whether the RX buffer has noticeably more space than the central was granted in credits.
+     */
+    bool hasCreditUpdate() const;
+
+    void notifyTxTaken();
+
+    std::atomic<TaskHandle_t> m_txTask;
+    std::atomic<uint16_t> m_rxAckPendingBytes{0};
+    /**
+     * Free RX buffer space sent along with the last acknowledge. The central may send this many bytes beyond the
+     * acknowledged ones.
+     */
+    std::atomic<uint16_t> m_rxAnnouncedCredits{0};
+    /**
+     * Set once the central agreed to respect the announced credits, writes exceeding them disconnect it. Until then
+     * writes not fitting into the RX buffer go to m_rxOverflowBuffer.
+     */
+    std::atomic<bool> m_rxCreditsEnabled{false};
     RingBuffer<uint8_t, 1024> m_rxBuffer;
     std::mutex m_rxBufferMutex;
     std::condition_variable m_rxBufferGivenNotifier;
-    std::condition_variable m_rxBufferTakenNotifier;
-    RingBuffer<uint8_t, 512> m_txBuffer;
+    /**
+     * Writes of centrals without credits that did not fit into the RX buffer. Their bytes are acknowledged once they
+     * moved on into the RX buffer, so centrals waiting for acknowledges pause meanwhile. m_rxOverflowMutex guards it
+     * and serializes both producers of the RX buffer, the BLE host and the reading command.
+     */
+    RingBuffer<uint8_t, 1024> m_rxOverflowBuffer;
+    std::mutex m_rxOverflowMutex;
+    /**
+     * Set while m_rxOverflowBuffer has data, so readers only take the lock to move it then.
+     */
+    std::atomic<bool> m_hasRxOverflow{false};
+    RingBuffer<uint8_t, 1024> m_txBuffer;
     std::mutex m_txBufferMutex;
     std::condition_variable m_txBufferNotifier;
+    /**
+     * Set at the end of a command. The TX task sends the remaining data followed by an empty chunk and clears it,
+     * writes wait until then.
+     */
+    std::atomic<bool> m_txFlushPending{false};
     int32_t m_connHandle;
+    std::atomic<uint16_t> m_mtu{BLE_ATT_MTU_DFLT};
+
+    /**
+     * Indices of metric updates not yet encoded into the metrics buffer of this client, only used by the metrics
+     * task. Encoding resumes at m_nextPendingMetric so frequently changing values can not starve the others.
+     */
+    std::bitset<MaximumMetrics> m_pendingMetrics;
+    size_t m_nextPendingMetric{0};
+    /**
+     * Pending updates of values with an index of at least @link Esp32BleUi::MaximumMetrics.
+     */
+    std::vector<std::shared_ptr<const KeyValueStore::Value> > m_pendingOverflowMetrics;
+    RingBuffer<uint8_t, 512> m_metricsBuffer;
+    /**
+     * Set by the metrics task when pending metrics did not fit into the metrics buffer, the TX task wakes it up again
+     * once data was sent.
+     */
+    std::atomic<bool> m_hasMetricsBacklog{false};
+    std::atomic<bool> m_metricsDictionaryRequested{false};
+    std::atomic<bool> m_metricsResyncRequested{false};
+    // Metric encoding state, only used by the metrics task.
+    bool m_useMetricsDictionary{false};
+    std::bitset<MaximumMetrics> m_announcedMetrics;
+
+    /**
+     * Set while a command transferring large amounts of data runs, see @link ConnectionProfile::Bulk.
+     */
+    std::atomic<bool> m_isBulkCommandRunning{false};
+    std::atomic<uint32_t> m_lastActivityMs{0};
+    /**
+     * Set by the metrics task when encoded metrics count as activity, the TX task updates m_lastActivityMs once they
+     * are sent. A UI only watching metrics keeps its connection out of the idle profile this way.
+     */
+    std::atomic<bool> m_hasMetricsActivity{false};
+    // Connection profile applied by the TX task.
+    ConnectionProfile m_connectionProfile{ConnectionProfile::Interactive};
+
+    // Send scheduling state, only used by the TX task.
+    int32_t m_txDeficit{0};
+    /**
+     * Virtual time per traffic class, advanced by the sent bytes divided by the class weight.
+     */
+    uint32_t m_trafficPass[TrafficClassCount]{};
+    uint32_t m_txBackoffMs{0};
+    uint32_t m_txRetryAtMs{0};
+    /**
+     * Set while received bytes wait for a coalesced acknowledge, which is sent at m_rxAckDueMs at the latest.
+     */
+    bool m_isRxAckDeferred{false};
+    uint32_t m_rxAckDueMs{0};
 };
@@ -16,82 +16,113 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 
+/**
+ * Lock free circular buffer for a single producer and a single consumer task.
+ *
+ * The producer only calls the write side (@link free, @link push, @link writeSpan, @link commitWrite), the consumer
+ * only the read side (@link available, @link pop, @link readSpan, @link read). Head and tail are free running
+ * counters, so a full buffer can be told apart from an empty one without wasting an element.
+ */
 template<typename T, size_t Size>
 class RingBuffer {
+    static_assert(Size > 0 && (Size & (Size - 1)) == 0, "RingBuffer size must be a power of two");
+
 public:
     RingBuffer() = default;
 
     RingBuffer(const RingBuffer&) = delete;
 
-    bool push(const T* val, size_t size) {
-        if (m_bufferFill + size > Size) {
-            return false;
-        }
-        memcpy(m_buffer + m_bufferFill, val, size);
-        m_bufferFill += size;
-        return true;
+    /**
+     * Append as many values as fit.
+     * @return Number of values appended.
+     */
+    size_t push(const T* values, size_t size) {
+        size = std::min(size, free());
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t firstPart = std::min(size, Size - (head & Mask));
+        memcpy(m_buffer + (head & Mask), values, firstPart * sizeof(T));
+        memcpy(m_buffer, values + firstPart, (size - firstPart) * sizeof(T));
+        m_head.store(head + size, std::memory_order_release);
+        return size;
     }
 
-    bool push(size_t size) {
-        if (m_bufferFill + size > Size) {
-            return false;
-        }
-        m_bufferFill += size;
-        return true;
+    /**
+     * @param size Set to the number of values that can be written contiguously at the returned position.
+     */
+    T* writeSpan(size_t* size) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        *size = std::min(free(), Size - (head & Mask));
+        return m_buffer + (head & Mask);
     }
 
-    bool pop(size_t amount) {
-        if (m_bufferFill < amount) {
-            return false;
-        }
-        memmove(m_buffer, m_buffer + amount, m_bufferFill - amount);
-        m_bufferFill -= amount;
-        return true;
+    /**
+     * Publish values written into the span returned by @link writeSpan.
+     */
+    void commitWrite(size_t size) {
+        m_head.store(m_head.load(std::memory_order_relaxed) + size, std::memory_order_release);
     }
 
-    const T* data() {
-        return m_buffer;
+    /**
+     * @param size Set to the number of values that can be read contiguously at the returned position.
+     */
+    const T* readSpan(size_t* size) const {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        *size = std::min(available(), Size - (tail & Mask));
+        return m_buffer + (tail & Mask);
     }
 
-    T* tail() {
-        return m_buffer + m_bufferFill;
+    /**
+     * Copy and remove up to size values.
+     * @return Number of values read.
+     */
+    size_t read(T* values, size_t size) {
+        size = std::min(size, available());
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t firstPart = std::min(size, Size - (tail & Mask));
+        memcpy(values, m_buffer + (tail & Mask), firstPart * sizeof(T));
+        memcpy(values + firstPart, m_buffer, (size - firstPart) * sizeof(T));
+        m_tail.store(tail + size, std::memory_order_release);
+        return size;
+    }
+
+    /**
+     * Remove values from the front, e.g. after processing the span returned by @link readSpan.
+     */
+    bool pop(size_t amount) {
+        if (available() < amount) {
+            return false;
+        }
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + amount, std::memory_order_release);
+        return true;
     }
 
     size_t available() const {
-        return m_bufferFill;
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
     }
 
     bool empty() const {
-        return m_bufferFill == 0;
+        return available() == 0;
     }
 
     size_t free() const {
-        if (m_shouldFlush) {
-            return 0;
-        }
-        return Size - m_bufferFill;
+        return Size - available();
     }
 
+    /**
+     * Drop all values and restart at the beginning of the storage, so the full capacity is contiguous again. Only
+     * valid while neither side is accessing the buffer concurrently.
+     */
     void clear() {
-        m_bufferFill = 0;
-        m_shouldFlush = false;
-    }
-
-    bool shouldFlush() const {
-        return m_shouldFlush;
-    }
-
-    void markFlush() {
-        m_shouldFlush = true;
-    }
-
-    void clearFlush() {
-        m_shouldFlush = false;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
     }
 
     static constexpr size_t capacity() {
@@ -99,7 +130,9 @@ public:
     }
 
 private:
-    T m_buffer[Size]{0};
-    volatile size_t m_bufferFill{0};
-    bool m_shouldFlush{false};
+    static constexpr size_t Mask = Size - 1;
+
+    T m_buffer[Size]{};
+    std::atomic<size_t> m_head{0};
+    std::atomic<size_t> m_tail{0};
 };
@@ -0,0 +1,217 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BleCommand.h"
+#include "Esp32BleUi.h"
+
+namespace Esp32BleUiCommands {
+class MetricsDictCommand : public Esp32Cli::ArgvCommand {
+public:
+    explicit MetricsDictCommand(Esp32BleUi& bleUi) : m_bleUi{bleUi} {}
+
+    using Esp32Cli::ArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        if (argv.size() != 2 || (strcmp(argv[1], "on") != 0 && strcmp(argv[1], "off") != 0)) {
+            Esp32Cli::Cli::printUsage(io, argv, *this);
+            return;
+        }
+        if (!m_bleUi.setMetricsDictionary(*client, strcmp(argv[1], "on") == 0)) {
+            io.println("Not a BLE client");
+        }
+    }
+
+    void printUsage(Print& output) const override {
+        output.println("on|off");
+    }
+
+    void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
+        Esp32Cli::Cli::printUsage(output, commandName, *this);
+        output.println("Send metric names once and later updates with a numeric id only.");
+    }
+
+private:
+    Esp32BleUi& m_bleUi;
+};
+
+class CreditsCommand : public Esp32Cli::ArgvCommand {
+public:
+    explicit CreditsCommand(Esp32BleUi& bleUi) : m_bleUi{bleUi} {}
+
+    using Esp32Cli::ArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        if (argv.size() != 2 || (strcmp(argv[1], "on") != 0 && strcmp(argv[1], "off") != 0)) {
+            Esp32Cli::Cli::printUsage(io, argv, *this);
+            return;
+        }
+        if (!m_bleUi.setRxCredits(*client, strcmp(argv[1], "on") == 0)) {
+            io.println("Not a BLE client");
+        }
+    }
+
+    void printUsage(Print& output) const override {
+        output.println("on|off");
+    }
+
+    void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
+        Esp32Cli::Cli::printUsage(output, commandName, *this);
+        output.println("Respect the RX credits sent with each acknowledge. Writes exceeding the credits disconnect");
+        output.println("the client instead of being queued until acknowledged.");
+    }
+
+private:
+    Esp32BleUi& m_bleUi;
+};
+
+class MetricsResyncCommand : public Esp32Cli::ArgvCommand {
+public:
+    explicit MetricsResyncCommand(Esp32BleUi& bleUi) : m_bleUi{bleUi} {}
+
+    using Esp32Cli::ArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        if (!m_bleUi.requestMetricsResync(*client)) {
+            io.println("Not a BLE client");
+        }
+    }
+
+    void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
+        output.println("Send all metrics again, in dictionary mode with their names.");
+    }
+
+private:
+    Esp32BleUi& m_bleUi;
+};
+
+class MetricsRateCommand : public Esp32Cli::ArgvCommand {
+public:
+    explicit MetricsRateCommand(Esp32BleUi& bleUi) : m_bleUi{bleUi} {}
+
+    using Esp32Cli::ArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        if (argv.size() == 1) {
+            io.printf("%u Hz\n", m_bleUi.getMetricsRate());
+            return;
+        }
+        if (argv.size() != 2) {
+            Esp32Cli::Cli::printUsage(io, argv, *this);
+            return;
+        }
+        char* end;
+        const unsigned long rate = std::strtoul(argv[1], &end, 0);
+        if (*end != '\0' || rate == 0 || rate > 1000) {
+            io.println("Rate must be between 1 and 1000 Hz");
+            return;
+        }
+        m_bleUi.setMetricsRate(rate);
+    }
+
+    void printUsage(Print& output) const override {
+        output.println("[max_rate_hz]");
+    }
+
+    void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
+        Esp32Cli::Cli::printUsage(output, commandName, *this);
+        output.println("Show or set how often changed metrics are sent to all clients.");
+    }
+
+private:
+    Esp32BleUi& m_bleUi;
+};
+
+/**
+ * Names of @link Esp32BleUi::TrafficClass values.
+ */
+const char* const TrafficClassNames[Esp32BleUi::TrafficClassCount] = {
+    "control", "interactive", "metrics", "bulk",
+};
+
+class TrafficCommand : public Esp32Cli::ArgvCommand {
+public:
+    explicit TrafficCommand(Esp32BleUi& bleUi) : m_bleUi{bleUi} {}
+
+    using Esp32Cli::ArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        if (argv.size() == 1) {
+            printTraffic(io);
+            return;
+        }
+        if (argv.size() == 2 && strcmp(argv[1], "reset") == 0) {
+            m_bleUi.resetTrafficStats();
+            return;
+        }
+        if (argv.size() != 3) {
+            Esp32Cli::Cli::printUsage(io, argv, *this);
+            return;
+        }
+        size_t classIndex = 1;
+        while (classIndex < Esp32BleUi::TrafficClassCount && strcmp(argv[1], TrafficClassNames[classIndex]) != 0) {
+            ++classIndex;
+        }
+        if (classIndex == Esp32BleUi::TrafficClassCount) {
+            io.println("Class must be interactive, metrics or bulk");
+            return;
+        }
+        char* end;
+        const unsigned long weight = std::strtoul(argv[2], &end, 0);
+        if (*end != '\0' || weight == 0 || weight > 100) {
+            io.println("Weight must be between 1 and 100");
+            return;
+        }
+        m_bleUi.setTrafficWeight(static_cast<Esp32BleUi::TrafficClass>(classIndex), weight);
+    }
+
+    void printUsage(Print& output) const override {
+        output.println("[reset | <interactive|metrics|bulk> <weight>]");
+    }
+
+    void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
+        Esp32Cli::Cli::printUsage(output, commandName, *this);
+        output.println("Show the BLE traffic per class, reset the counters or set the bandwidth share of a class.");
+    }
+
+private:
+    void printTraffic(Print& io) const {
+        io.println("class       weight notifications bytes");
+        for (size_t i = 0; i < Esp32BleUi::TrafficClassCount; ++i) {
+            const auto trafficClass = static_cast<Esp32BleUi::TrafficClass>(i);
+            const auto stats = m_bleUi.getTrafficStats(trafficClass);
+            if (trafficClass == Esp32BleUi::TrafficClass::Control) {
+                io.printf("%-11s %6s", TrafficClassNames[i], "-");
+            } else {
+                io.printf("%-11s %6u", TrafficClassNames[i], m_bleUi.getTrafficWeight(trafficClass));
+            }
+            io.printf(" %13u %u\n", stats.notifications, stats.bytes);
+        }
+        io.printf("buffer polls: %u\n", m_bleUi.getTxBufferPolls());
+    }
+
+    Esp32BleUi& m_bleUi;
+};
+
+BleCommand::BleCommand(Esp32BleUi& bleUi) {
+    addCommand<CreditsCommand>("credits", bleUi);
+    addCommand<MetricsDictCommand>("metrics-dict", bleUi);
+    addCommand<MetricsResyncCommand>("metrics-resync", bleUi);
+    addCommand<MetricsRateCommand>("metrics-rate", bleUi);
+    addCommand<TrafficCommand>("traffic", bleUi);
+}
+}
@@ -18,6 +18,10 @@
 
 #include "Esp32BleUi.h"
 #include "Esp32BleUiClient.h"
+#include "BleCommand.h"
+
+#include <esp_ota_ops.h>
+#include <esp_rom_crc.h>
 
 #define BLE_SERVICE_UUID "afc3eba8-ba5e-42be-8d3c-94c7fe325ba1"
 #define RX_CHARACTERISTIC_UUID "f72bac71-f66f-4cce-b83f-a4218f482706"
@@ -25,13 +29,90 @@
 #define TX_CHARACTERISTIC_UUID "f72bac71-f66f-4cce-b83f-a4218f482707"
 #define UI_CHARACTERISTIC_UUID "f72bac71-f66f-4cce-b83f-a4218f482709"
 
-#define BLE_CHUNK_SIZE 222u
+// Allows 512 byte notifications for centrals supporting the maximum attribute size.
+#define BLE_PREFERRED_MTU 517
+// RX acknowledges are deferred while TX data is pending until this many bytes were received or the delay passed,
+// about one connection interval of the bulk profile.
+#define RX_ACK_COALESCE_SIZE 256u
+#define RX_ACK_MAX_DELAY_MS 8u
+// New credits are announced once this much more RX buffer space is free than the central knows of.
+#define RX_CREDIT_UPDATE_SIZE 256u
+// Bytes each client may send per round of the TX scheduler.
+#define TX_QUANTUM 512
+// Scales the virtual time of traffic classes so small weights keep precision.
+#define TRAFFIC_PASS_SCALE 256u
+// Clients failing to send for other reasons than a lack of buffers are retried with an exponential backoff.
+#define TX_MIN_BACKOFF_MS 10u
+#define TX_MAX_BACKOFF_MS 320u
+// Largest metric record, name and value.
+#define METRIC_RECORD_SIZE 128
+// The metrics task also encodes records and builds the scan response on its stack.
+#define METRICS_TASK_STACK_SIZE 4096
+// Connections without CLI traffic or metric updates for this long switch to the idle profile.
+#define IDLE_PROFILE_DELAY_MS 30000u
+// The original ESP32 only supports Bluetooth 4.2 without the 2M PHY.
+#define BLE_HAS_2M_PHY !CONFIG_IDF_TARGET_ESP32
+
+namespace {
+struct ConnectionParameters {
+    uint16_t minInterval;
+    uint16_t maxInterval;
+    uint16_t latency;
+    uint16_t supervisionTimeout;
+};
+
+/**
+ * Intervals in 1.25 ms, supervision timeouts in 10 ms units, indexed by @link Esp32BleUi::ConnectionProfile.
+ */
+const ConnectionParameters ConnectionProfileParameters[] = {
+    {80, 160, 4, 600},
+    {8, 24, 0, 400},
+    {6, 6, 0, 400},
+};
+
+/**
+ * Commands moving large amounts of data, optionally limited to sub commands starting with a prefix.
+ */
+const struct {
+    const char* command;
+    const char* subCommandPrefix;
+} BulkCommands[] = {
+    {"firmware", "flash-"},
+    {"firmware", "dump"},
+    {"fs", "write"},
+    {"core-dump", nullptr},
+    {"z", nullptr},
+};
+
+bool isBulkCommand(Esp32Cli::ArgvView argv) {
+    while (argv.size() >= 3 && strcmp(argv[0], "tag") == 0) {
+        argv = argv.nestedCommand(2);
+    }
+    if (argv.size() == 0) {
+        return false;
+    }
+    for (const auto& bulkCommand: BulkCommands) {
+        if (strcmp(argv[0], bulkCommand.command) != 0) {
+            continue;
+        }
+        if (!bulkCommand.subCommandPrefix) {
+            return true;
+        }
+        if (argv.size() >= 2 &&
+            strncmp(argv[1], bulkCommand.subCommandPrefix, strlen(bulkCommand.subCommandPrefix)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+}
 
 // #define VERBOSE_LOG
 
 Esp32BleUi::Esp32BleUi(std::shared_ptr<Esp32Cli::Cli> cli)
     : m_cli(std::move(cli)) {
     NimBLEDevice::init(m_cli->getHostname());
+    NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
 
     // TODO: Fix secure encrypted BLE for encrypted firmware updates.
 #if 0
@@ -53,6 +134,7 @@ Esp32BleUi::Esp32BleUi(std::shared_ptr<Esp32Cli::Cli> cli)
     m_uiCharacteristic = m_bleService->createCharacteristic(UI_CHARACTERISTIC_UUID, NOTIFY | READ);
 
     m_rxCharacteristic->setCallbacks(this);
+    m_rxAckCharacteristic->setCallbacks(this);
 
     m_bleService->start();
 
@@ -69,6 +151,8 @@ Esp32BleUi::Esp32BleUi(std::shared_ptr<Esp32Cli::Cli> cli)
         log_e("Failed to create BLE Cli TX task");
         ESP.restart();
     }
+
+    m_cli->addCommand<Esp32BleUiCommands::BleCommand>("ble", *this);
 }
 
 Esp32BleUi::~Esp32BleUi() {
@@ -86,6 +170,18 @@ void Esp32BleUi::onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_des
     }
 }
 
+void Esp32BleUi::onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc, uint16_t subValue) {
+    if (pCharacteristic != m_rxAckCharacteristic || subValue == 0) {
+        return;
+    }
+    // Credits announced before the central subscribed were not received.
+    auto client = findClient(desc->conn_handle);
+    if (client) {
+        client->m_rxAnnouncedCredits = 0;
+        xTaskNotifyGive(m_txTask);
+    }
+}
+
 void Esp32BleUi::onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
     std::unique_lock<std::mutex> clientsLock{m_clientsMutex};
     m_clients.emplace_back(std::make_shared<Client>(m_cli, m_txTask, desc->conn_handle));
@@ -99,14 +195,25 @@ void Esp32BleUi::onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
     }
 
     pServer->setDataLen(desc->conn_handle, 0x00FB);
+    client->m_mtu = std::max<uint16_t>(ble_att_mtu(desc->conn_handle), BLE_ATT_MTU_DFLT);
 
     pServer->updateConnParams(desc->conn_handle, 8, 24, 0, 400);
 
-    auto clientPtr = new std::shared_ptr<Client>(client);
-    if (xTaskCreatePinnedToCore(&runClient, "ble_client", 4096, clientPtr, 0, nullptr, ARDUINO_RUNNING_CORE) != pdPASS) {
-        log_e("Failed to create BLE client task");
-        delete clientPtr;
-        m_clients.pop_back();
+    // Commands waiting for more input block their executor worker until the data arrived or the client disconnected.
+    client->setTimeout(1000 * 60 * 60 * 24);
+    client->m_lastActivityMs = millis();
+
+    // Announce the initial RX credits.
+    xTaskNotifyGive(m_txTask);
+}
+
+void Esp32BleUi::onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {
+    std::unique_lock<std::mutex> clientsLock{m_clientsMutex};
+    for (auto& client: m_clients) {
+        if (client->m_connHandle == desc->conn_handle) {
+            client->m_mtu = std::max<uint16_t>(MTU, BLE_ATT_MTU_DFLT);
+            Serial.printf("Client %i uses MTU %i\n", desc->conn_handle, MTU);
+        }
     }
 }
 
@@ -127,7 +234,6 @@ void Esp32BleUi::onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
     client->m_connHandle = -1;
     client->m_txBufferNotifier.notify_all();
     client->m_rxBufferGivenNotifier.notify_all();
-    client->m_rxBufferTakenNotifier.notify_all();
     client->onDisconnect();
     m_clients.erase(clientIterator);
     Serial.printf("Client %i disconnected\n", desc->conn_handle);
@@ -135,84 +241,146 @@ void Esp32BleUi::onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
 
 void Esp32BleUi::setKeyValueStore(std::shared_ptr<KeyValueStore> keyValueStore) {
     m_metrics = std::move(keyValueStore);
-    if (xTaskCreatePinnedToCore(&Esp32BleUi::runMetrics, "metrics", 2048, this, 2, &m_metricsTask, ARDUINO_RUNNING_CORE) != pdPASS) {
+    // The TX task is already running, the metrics task only starts below.
+    std::atomic_store(&m_profileMetric, m_metrics->createValue<uint8_t>("Ble", "Profile", false, 0));
+    if (xTaskCreatePinnedToCore(&Esp32BleUi::runMetrics, "metrics", METRICS_TASK_STACK_SIZE, this, 2, &m_metricsTask, ARDUINO_RUNNING_CORE) != pdPASS) {
         log_e("Failed to create BLE Cli metrics task");
         ESP.restart();
     }
     m_metrics->addValueChangeCallback(this, [this](const std::shared_ptr<const KeyValueStore::Value>& value) {
-        std::unique_lock<std::mutex> lock{m_metricsMutex};
-        m_changedMetrics.set(value->name(), value);
+        const size_t index = value->index();
+        if (index >= MaximumMetrics) {
+            std::unique_lock<std::mutex> overflowMetricsLock{m_overflowMetricsMutex};
+            if (std::find(m_overflowMetrics.begin(), m_overflowMetrics.end(), value) == m_overflowMetrics.end()) {
+                m_overflowMetrics.push_back(value);
+            }
+        } else {
+            m_dirtyMetrics[index / 32].fetch_or(1u << (index % 32));
+        }
         xTaskNotifyGive(m_metricsTask);
     });
 }
 
+void Esp32BleUi::setMetricsRate(uint32_t maximumRateHz) {
+    m_metricsFlushIntervalMs = 1000 / std::max<uint32_t>(maximumRateHz, 1);
+}
+
+uint32_t Esp32BleUi::getMetricsRate() const {
+    return 1000 / std::max<uint32_t>(m_metricsFlushIntervalMs, 1);
+}
+
+bool Esp32BleUi::setMetricsDictionary(const Esp32Cli::Client& cliClient, bool isEnabled) {
+    auto client = findClient(cliClient);
+    if (!client) {
+        return false;
+    }
+    client->m_metricsDictionaryRequested = isEnabled;
+    return true;
+}
+
+bool Esp32BleUi::setRxCredits(const Esp32Cli::Client& cliClient, bool isEnabled) {
+    auto client = findClient(cliClient);
+    if (!client) {
+        return false;
+    }
+    client->m_rxCreditsEnabled = isEnabled;
+    return true;
+}
+
+bool Esp32BleUi::requestMetricsResync(const Esp32Cli::Client& cliClient) {
+    auto client = findClient(cliClient);
+    if (!client) {
+        return false;
+    }
+    client->m_metricsResyncRequested = true;
+    if (m_metricsTask) {
+        xTaskNotifyGive(m_metricsTask);
+    }
+    return true;
+}
+
+std::shared_ptr<Esp32BleUi::Client> Esp32BleUi::findClient(uint16_t connHandle) {
+    std::unique_lock<std::mutex> clientsLock{m_clientsMutex};
+    for (const auto& client: m_clients) {
+        if (client->m_connHandle == connHandle) {
+            return client;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Esp32BleUi::Client> Esp32BleUi::findClient(const Esp32Cli::Client& cliClient) {
+    std::unique_lock<std::mutex> clientsLock{m_clientsMutex};
+    for (const auto& client: m_clients) {
+        if (client.get() == &cliClient) {
+            return client;
+        }
+    }
+    return nullptr;
+}
+
 size_t Esp32BleUi::Client::write(const uint8_t* buffer, size_t size) {
-    std::unique_lock<std::mutex> bufferLock{m_txBufferMutex};
+    m_lastActivityMs = millis();
     size_t bytesWritten = 0;
     do {
         if (!m_txTask) {
             return bytesWritten;
         }
-        size_t writeSize = std::min<size_t>(size - bytesWritten, m_txBuffer.free());
-        m_txBuffer.push(buffer + bytesWritten, writeSize);
-        xTaskNotifyGive(m_txTask);
-        bytesWritten += writeSize;
+        if (!m_txFlushPending) {
+            bytesWritten += m_txBuffer.push(buffer + bytesWritten, size - bytesWritten);
+            notifyTxTask();
+        }
         if (bytesWritten == size) {
             break;
         }
 #ifdef VERBOSE_LOG
         Serial.printf("Client %i waiting for TX buffer space (%i Bytes)\n", m_connHandle, size - bytesWritten);
 #endif
-        m_txBufferNotifier.wait(bufferLock);
+        std::unique_lock<std::mutex> bufferLock{m_txBufferMutex};
+        m_txBufferNotifier.wait(bufferLock, [this]() {
+            return !m_txTask || (!m_txFlushPending && m_txBuffer.free() > 0);
+        });
     } while (true);
     return bytesWritten;
 }
 
 size_t Esp32BleUi::Client::write(uint8_t uint8) {
-    std::unique_lock<std::mutex> bufferLock{m_txBufferMutex};
-    while (m_txTask && m_txBuffer.free() < 1) {
-#ifdef VERBOSE_LOG
-        Serial.printf("Client %i waiting for TX buffer space (1 Byte)\n", m_connHandle);
-#endif
-        m_txBufferNotifier.wait(bufferLock);
-    }
-    if (!m_txTask) {
-        return 0;
-    }
-    m_txBuffer.push(&uint8, 1);
-    xTaskNotifyGive(m_txTask);
-    return 1;
+    return write(&uint8, 1);
 }
 
 int Esp32BleUi::Client::availableForWrite() {
-    std::unique_lock<std::mutex> bufferLock{m_txBufferMutex};
-    return static_cast<int>(m_txBuffer.free());
+    return m_txFlushPending ? 0 : static_cast<int>(m_txBuffer.free());
+}
+
+bool Esp32BleUi::Client::hasPendingInput() {
+    return m_connHandle >= 0 && !m_rxBuffer.empty();
 }
 
 int Esp32BleUi::Client::available() {
-    std::unique_lock<std::mutex> bufferLock{m_rxBufferMutex};
     return static_cast<int>(m_rxBuffer.available());
 }
 
 size_t Esp32BleUi::Client::readBytes(char* buffer, size_t length) {
-    std::unique_lock<std::mutex> bufferLock{m_rxBufferMutex};
     size_t bytesRead = 0;
     do {
         if (m_connHandle < 0) {
             return 0;
         }
-        size_t readSize = std::min(length - bytesRead, m_rxBuffer.available());
-        memcpy(buffer + bytesRead, m_rxBuffer.data(), readSize);
-        m_rxBuffer.pop(readSize);
-        bytesRead += readSize;
-        m_rxBufferTakenNotifier.notify_all();
+        const size_t readSize = m_rxBuffer.read(reinterpret_cast<uint8_t*>(buffer) + bytesRead, length - bytesRead);
+        if (readSize > 0) {
+            bytesRead += readSize;
+            notifyRxTaken();
+        }
         if (bytesRead == length) {
             break;
         }
 #ifdef VERBOSE_LOG
-        Serial.printf("Client %i waiting for %i bytes\n", m_connHandle, length - readSize);
+        Serial.printf("Client %i waiting for %i bytes\n", m_connHandle, length - bytesRead);
 #endif
-        m_rxBufferGivenNotifier.wait(bufferLock);
+        std::unique_lock<std::mutex> bufferLock{m_rxBufferMutex};
+        m_rxBufferGivenNotifier.wait(bufferLock, [this]() {
+            return m_connHandle < 0 || !m_rxBuffer.empty();
+        });
     } while (true);
 #ifdef VERBOSE_LOG
     Serial.printf("Client %i got %i / %i bytes (%i Bytes left in buffer)\n", m_connHandle, bytesRead, length, m_rxBuffer.available());
@@ -221,18 +389,20 @@ size_t Esp32BleUi::Client::readBytes(char* buffer, size_t length) {
 }
 
 int Esp32BleUi::Client::read() {
-    std::unique_lock<std::mutex> bufferLock{m_rxBufferMutex};
-    int value = -1;
-    while (m_connHandle >= 0 && !m_rxBuffer.available()) {
+    if (m_rxBuffer.empty()) {
 #ifdef VERBOSE_LOG
         Serial.printf("Client %i waiting for 1 byte\n", m_connHandle);
 #endif
-        m_rxBufferGivenNotifier.wait(bufferLock);
+        std::unique_lock<std::mutex> bufferLock{m_rxBufferMutex};
+        m_rxBufferGivenNotifier.wait(bufferLock, [this]() {
+            return m_connHandle < 0 || !m_rxBuffer.empty();
+        });
     }
-    if (m_connHandle >= 0 && m_rxBuffer.available()) {
-        value = m_rxBuffer.data()[0];
-        m_rxBuffer.pop(1);
-        m_rxBufferTakenNotifier.notify_all();
+    int value = -1;
+    uint8_t byte;
+    if (m_connHandle >= 0 && m_rxBuffer.read(&byte, 1) == 1) {
+        value = byte;
+        notifyRxTaken();
     }
 #ifdef VERBOSE_LOG
     Serial.printf("Client %i got %s / one bytes (%i Bytes left in buffer)\n", m_connHandle, value >= 0 ? "1" : "0",
@@ -242,185 +412,698 @@ int Esp32BleUi::Client::read() {
 }
 
 int Esp32BleUi::Client::peek() {
-    std::unique_lock<std::mutex> bufferLock{m_rxBufferMutex};
-    if (m_rxBuffer.available()) {
-        return m_rxBuffer.data()[0];
+    size_t size;
+    const uint8_t* data = m_rxBuffer.readSpan(&size);
+    if (size > 0) {
+        return data[0];
     }
     return -1;
 }
 
+size_t Esp32BleUi::Client::borrowInput(const char** data, const ExecType execType) {
+    if (execType == ExecType::Blocking && m_rxBuffer.empty()) {
+        std::unique_lock<std::mutex> bufferLock{m_rxBufferMutex};
+        m_rxBufferGivenNotifier.wait(bufferLock, [this]() {
+            return m_connHandle < 0 || !m_rxBuffer.empty();
+        });
+    }
+    if (m_connHandle < 0) {
+        return 0;
+    }
+    // Only this client consumes from the RX buffer, so the span stays valid until consumed. Data wrapping around the
+    // end of the buffer is returned by the next call.
+    size_t size;
+    *data = reinterpret_cast<const char*>(m_rxBuffer.readSpan(&size));
+    return size;
+}
+
+void Esp32BleUi::Client::consumeInput(const size_t size) {
+    if (size == 0) {
+        return;
+    }
+    m_rxBuffer.pop(size);
+    notifyRxTaken();
+}
+
+void Esp32BleUi::Client::executeCommand(const Esp32Cli::ArgvView& argv) {
+    const bool isBulk = isBulkCommand(argv);
+    if (isBulk) {
+        m_isBulkCommandRunning = true;
+        notifyTxTask();
+    }
+    Esp32Cli::Client::executeCommand(argv);
+    if (isBulk) {
+        m_isBulkCommandRunning = false;
+        m_lastActivityMs = millis();
+        notifyTxTask();
+    }
+}
+
 void Esp32BleUi::Client::onCommandEnd() {
-    std::unique_lock<std::mutex> bufferLock{m_txBufferMutex};
-    while (m_txBuffer.shouldFlush()) {
-        m_txBufferNotifier.wait(bufferLock);
+    if (isCommandTagged()) {
+        // The end frame of the tagged command already delimits its output.
+        notifyTxTask();
+        return;
     }
-    m_txBuffer.markFlush();
-    if (m_txTask) {
-        xTaskNotifyGive(m_txTask);
+    if (m_txFlushPending) {
+        std::unique_lock<std::mutex> bufferLock{m_txBufferMutex};
+        m_txBufferNotifier.wait(bufferLock, [this]() {
+            return !m_txTask || !m_txFlushPending;
+        });
     }
+    m_txFlushPending = true;
+    notifyTxTask();
 }
 
-void Esp32BleUi::onRxWrite(ble_gap_conn_desc* desc) {
-    std::shared_ptr<Client> client; {
-        std::unique_lock<std::mutex> clientsLock{m_clientsMutex};
-        auto clientIterator = std::find_if(
-            m_clients.begin(), m_clients.end(),
-            [desc](const std::shared_ptr<Client>& client) {
-                return client->m_connHandle == desc->conn_handle;
-            });
-        if (clientIterator == m_clients.end()) {
-            Serial.printf("Got %i bytes for unknown client\n", m_rxCharacteristic->getValue().size());
-            return;
+void Esp32BleUi::Client::notifyTxTask() const {
+    const TaskHandle_t txTask = m_txTask;
+    if (txTask) {
+        xTaskNotifyGive(txTask);
+    }
+}
+
+void Esp32BleUi::Client::notifyRxGiven() {
+    std::unique_lock<std::mutex> bufferLock{m_rxBufferMutex};
+    m_rxBufferGivenNotifier.notify_all();
+}
+
+void Esp32BleUi::Client::notifyRxTaken() {
+    // Pairs with the fence in onRxWrite: either the overflowing write sees the freed space or this sees the overflow.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_hasRxOverflow) {
+        std::unique_lock<std::mutex> overflowLock{m_rxOverflowMutex};
+        moveRxOverflow();
+    }
+    if (hasCreditUpdate()) {
+        notifyTxTask();
+    }
+}
+
+void Esp32BleUi::Client::moveRxOverflow() {
+    size_t movedBytes = 0;
+    while (!m_rxOverflowBuffer.empty()) {
+        size_t size;
+        const uint8_t* data = m_rxOverflowBuffer.readSpan(&size);
+        size = m_rxBuffer.push(data, size);
+        if (size == 0) {
+            break;
         }
-        client = *clientIterator;
+        m_rxOverflowBuffer.pop(size);
+        movedBytes += size;
+    }
+    m_hasRxOverflow = !m_rxOverflowBuffer.empty();
+    if (movedBytes > 0) {
+        m_rxAckPendingBytes += movedBytes;
+        notifyRxGiven();
+        notifyTxTask();
+    }
+}
+
+bool Esp32BleUi::Client::hasCreditUpdate() const {
+    const uint16_t pendingBytes = m_rxAckPendingBytes;
+    const uint16_t announcedCredits = m_rxAnnouncedCredits;
+    // The central counts the bytes sent since the last acknowledge against the announced credits.
+    const size_t knownCredits = announcedCredits - std::min(pendingBytes, announcedCredits);
+    return m_rxBuffer.free() >= knownCredits + RX_CREDIT_UPDATE_SIZE;
+}
+
+void Esp32BleUi::Client::notifyTxTaken() {
+    std::unique_lock<std::mutex> bufferLock{m_txBufferMutex};
+    m_txBufferNotifier.notify_all();
+}
+
+void Esp32BleUi::onRxWrite(ble_gap_conn_desc* desc) {
+    auto client = findClient(desc->conn_handle);
+    if (!client) {
+        Serial.printf("Got %i bytes for unknown client\n", m_rxCharacteristic->getValue().size());
+        return;
     }
     auto value = m_rxCharacteristic->getValue();
 
-    std::unique_lock<std::mutex> clientBufferLock{client->m_rxBufferMutex};
-    while (client->m_rxBuffer.free() < value.size()) {
-#ifdef VERBOSE_LOG
-        Serial.printf("Client %i waiting for buffer space (%i / %i Bytes available)\n", client->m_connHandle,
-                      client->m_rxBuffer.free(), value.size());
-#endif
-        client->m_rxBufferTakenNotifier.wait(clientBufferLock);
+    // Never wait for a command to consume data here, that would stall this NimBLE host task and all connections.
+    {
+        std::unique_lock<std::mutex> overflowLock{client->m_rxOverflowMutex};
+        if (client->m_rxCreditsEnabled && client->m_rxBuffer.free() < value.size()) {
+            log_e("Client %i exceeded its RX credits (%i > %i Bytes), disconnecting", desc->conn_handle, value.size(),
+                  client->m_rxBuffer.free());
+            m_bleServer->disconnect(desc->conn_handle);
+            return;
+        }
+        if (!client->m_hasRxOverflow && client->m_rxBuffer.free() >= value.size()) {
+            client->m_rxBuffer.push(value.data(), value.size());
+            client->m_rxAckPendingBytes += value.size();
+        } else if (client->m_rxOverflowBuffer.free() >= value.size()) {
+            client->m_rxOverflowBuffer.push(value.data(), value.size());
+            client->m_hasRxOverflow = true;
+            // Pairs with the fence in notifyRxTaken.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            client->moveRxOverflow();
+        } else {
+            log_e("Client %i overflowed its RX buffers, dropping %i Bytes", desc->conn_handle, value.size());
+            return;
+        }
     }
-    client->m_rxBuffer.push(value.data(), value.size());
-    client->m_rxAckPendingBytes += value.size();
-    client->m_rxBufferGivenNotifier.notify_all();
+    client->m_lastActivityMs = millis();
+    client->notifyRxGiven();
 #ifdef VERBOSE_LOG
     Serial.printf("Client %i received %i Bytes (%i Bytes in buffer)\n", client->m_connHandle,
                   value.size(), client->m_rxBuffer.available());
 #endif
+    m_cli->schedule(client);
     if (m_txTask) {
         xTaskNotifyGive(m_txTask);
     }
 }
 
 [[noreturn]] void Esp32BleUi::processTxQueue() {
-    bool dataToSend = false;
-    os_mbuf* om;
+    TickType_t waitTicks = pdMS_TO_TICKS(1000);
     while (true) {
-        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(dataToSend ? 10 : 1000));
-        dataToSend = false;
+        // Writes and received data wake up the task. NimBLE reports a notification as sent once it is queued and has
+        // no event for freed buffers, so an exhausted buffer pool is polled every tick (previously every 10 ms).
+        ulTaskNotifyTake(pdTRUE, waitTicks);
 
-        // Check if attempting to send a BLE packet has a remote chance to succeed.
-        om = ble_hs_mbuf_att_pkt();
-        if (om == nullptr) {
-            dataToSend = true;
-            continue;
+        {
+            std::unique_lock<std::mutex> clientsLock{m_clientsMutex};
+            m_txClients = m_clients;
+        }
+        bool outOfBuffers = false;
+        while (sendRound(&outOfBuffers) && !outOfBuffers) {
         }
-        os_mbuf_free_chain(om);
+        updateConnectionProfiles();
 
-        std::unique_lock<std::mutex> clientsLock{m_clientsMutex};
-        for (auto& client: m_clients) {
-            int rxAckSendRet = -999;
-            int txRet = -999;
-            std::unique_lock<std::mutex> clientBufferLock{client->m_txBufferMutex};
-            if (client->m_rxAckPendingBytes > 0) {
-                om = ble_hs_mbuf_from_flat(&client->m_rxAckPendingBytes, sizeof(client->m_rxAckPendingBytes));
-                if (om == nullptr) {
-                    dataToSend = true;
-                    break;
+        waitTicks = pdMS_TO_TICKS(1000);
+        if (outOfBuffers) {
+            m_txBufferPolls.fetch_add(1);
+            waitTicks = 1;
+        } else {
+            const uint32_t now = millis();
+            for (const auto& client: m_txClients) {
+                const auto retryIn = static_cast<int32_t>(client->m_txRetryAtMs - now);
+                if (client->m_txBackoffMs > 0 && retryIn >= 0) {
+                    waitTicks = std::min<TickType_t>(waitTicks, pdMS_TO_TICKS(retryIn) + 1);
+                } else if (client->m_isRxAckDeferred) {
+                    const auto ackDueIn = std::max<int32_t>(static_cast<int32_t>(client->m_rxAckDueMs - now), 0);
+                    waitTicks = std::min<TickType_t>(waitTicks, pdMS_TO_TICKS(ackDueIn) + 1);
                 }
-                rxAckSendRet = ble_gatts_notify_custom(client->m_connHandle, m_rxAckCharacteristic->getHandle(), om);
-                if (rxAckSendRet == 0) {
+            }
+        }
+        m_txClients.clear();
+    }
+}
+
+void Esp32BleUi::updateConnectionProfiles() {
+    const uint32_t now = millis();
+    auto highestProfile = ConnectionProfile::Idle;
+    for (const auto& client: m_txClients) {
+        auto profile = ConnectionProfile::Interactive;
+        if (client->m_isBulkCommandRunning) {
+            profile = ConnectionProfile::Bulk;
+        } else if (now - client->m_lastActivityMs >= IDLE_PROFILE_DELAY_MS) {
+            profile = ConnectionProfile::Idle;
+        }
+        if (profile != client->m_connectionProfile && client->m_connHandle >= 0) {
+            applyConnectionProfile(*client, profile);
+        }
+        highestProfile = std::max(highestProfile, client->m_connectionProfile);
+    }
+    const auto profileMetric = std::atomic_load(&m_profileMetric);
+    if (profileMetric && profileMetric->value() != static_cast<uint8_t>(highestProfile)) {
+        profileMetric->setValue(static_cast<uint8_t>(highestProfile));
+    }
+}
+
+bool Esp32BleUi::applyConnectionProfile(Client& client, ConnectionProfile profile) {
+    const auto& parameters = ConnectionProfileParameters[static_cast<size_t>(profile)];
+    ble_gap_upd_params updateParameters{};
+    updateParameters.itvl_min = parameters.minInterval;
+    updateParameters.itvl_max = parameters.maxInterval;
+    updateParameters.latency = parameters.latency;
+    updateParameters.supervision_timeout = parameters.supervisionTimeout;
+    const int ret = ble_gap_update_params(client.m_connHandle, &updateParameters);
+    if (ret != 0) {
 #ifdef VERBOSE_LOG
-                    Serial.printf("Sent RX ack (%i) to client %i\n", client->m_rxAckPendingBytes, client->m_connHandle);
+        Serial.printf("Client %i connection parameter update failed (%i)\n", client.m_connHandle, ret);
 #endif
-                    client->m_rxAckPendingBytes = 0;
-                } else {
-                    dataToSend = true;
-                    break;
-                }
+        return false;
+    }
+#if BLE_HAS_2M_PHY
+    const uint8_t phyMask = profile == ConnectionProfile::Bulk ? BLE_GAP_LE_PHY_2M_MASK : BLE_GAP_LE_PHY_1M_MASK;
+    ble_gap_set_prefered_le_phy(client.m_connHandle, phyMask, phyMask, BLE_GAP_LE_PHY_CODED_ANY);
+#endif
+    client.m_connectionProfile = profile;
+    return true;
+}
+
+bool Esp32BleUi::sendRound(bool* outOfBuffers) {
+    bool sent = false;
+    const uint32_t now = millis();
+    const size_t clientCount = m_txClients.size();
+    for (size_t i = 0; i < clientCount; ++i) {
+        const size_t index = (m_txNextClient + i) % clientCount;
+        auto& client = *m_txClients[index];
+        if (client.m_txBackoffMs > 0 && static_cast<int32_t>(client.m_txRetryAtMs - now) > 0) {
+            continue;
+        }
+        // Deficit round-robin: each client may send a quantum of bytes per round, a larger last chunk is paid back
+        // in the next round. Credit of idle or blocked clients does not pile up.
+        const int32_t quantum = getTxQuantum(client);
+        client.m_txDeficit = std::min<int32_t>(client.m_txDeficit + quantum, quantum);
+        while (client.m_txDeficit > 0) {
+            size_t sentBytes = 0;
+            const auto result = sendPending(client, &sentBytes);
+            if (result == SendResult::Sent) {
+                client.m_txDeficit -= static_cast<int32_t>(sentBytes);
+                client.m_txBackoffMs = 0;
+                sent = true;
+                continue;
             }
-            if (client->m_txBuffer.available() || client->m_txBuffer.shouldFlush()) {
-                size_t sendSize = std::min(BLE_CHUNK_SIZE, client->m_txBuffer.available());
-                om = ble_hs_mbuf_from_flat(client->m_txBuffer.data(), sendSize);
-                if (om == nullptr) {
-                    dataToSend = true;
-                    break;
-                }
-                txRet = ble_gatts_notify_custom(client->m_connHandle, m_txCharacteristic->getHandle(), om);
-                if (txRet == 0) {
-                    client->m_txBuffer.pop(sendSize);
-                    if (sendSize == 0) {
-                        client->m_txBuffer.clearFlush();
-                    }
-                    client->m_txBufferNotifier.notify_all();
+            if (result == SendResult::OutOfBuffers) {
+                // The buffer pool is shared by all connections, this client continues first once buffers are free.
+                m_txNextClient = index;
+                *outOfBuffers = true;
+                return sent;
+            }
+            if (result == SendResult::Failed) {
+                client.m_txBackoffMs = std::min<uint32_t>(std::max<uint32_t>(client.m_txBackoffMs * 2, TX_MIN_BACKOFF_MS),
+                                                        TX_MAX_BACKOFF_MS);
+                client.m_txRetryAtMs = now + client.m_txBackoffMs;
+            }
+            client.m_txDeficit = 0;
+            break;
+        }
+    }
+    if (clientCount > 0) {
+        m_txNextClient = (m_txNextClient + 1) % clientCount;
+    }
+    return sent;
+}
+
+int32_t Esp32BleUi::getTxQuantum(const Client& client) const {
+    if (!client.m_isBulkCommandRunning) {
+        return TX_QUANTUM;
+    }
+    const uint32_t interactiveWeight = getTrafficWeight(TrafficClass::Interactive);
+    const uint32_t bulkWeight = getTrafficWeight(TrafficClass::Bulk);
+    if (bulkWeight >= interactiveWeight) {
+        return TX_QUANTUM;
+    }
+    return std::max<int32_t>(TX_QUANTUM * bulkWeight / interactiveWeight, 1);
+}
+
+void Esp32BleUi::countTraffic(TrafficClass trafficClass, size_t bytes) {
+    m_trafficNotifications[static_cast<size_t>(trafficClass)].fetch_add(1);
+    m_trafficBytes[static_cast<size_t>(trafficClass)].fetch_add(bytes);
+}
+
+void Esp32BleUi::setTrafficWeight(TrafficClass trafficClass, uint8_t weight) {
+    m_trafficWeights[static_cast<size_t>(trafficClass)] = std::max<uint8_t>(weight, 1);
+}
+
+uint8_t Esp32BleUi::getTrafficWeight(TrafficClass trafficClass) const {
+    return m_trafficWeights[static_cast<size_t>(trafficClass)];
+}
+
+Esp32BleUi::TrafficStats Esp32BleUi::getTrafficStats(TrafficClass trafficClass) const {
+    return {m_trafficNotifications[static_cast<size_t>(trafficClass)], m_trafficBytes[static_cast<size_t>(trafficClass)]};
+}
+
+uint32_t Esp32BleUi::getTxBufferPolls() const {
+    return m_txBufferPolls;
+}
+
+void Esp32BleUi::resetTrafficStats() {
+    for (size_t i = 0; i < TrafficClassCount; ++i) {
+        m_trafficNotifications[i] = 0;
+        m_trafficBytes[i] = 0;
+    }
+    m_txBufferPolls = 0;
+}
+
+Esp32BleUi::SendResult Esp32BleUi::notify(const Client& client, NimBLECharacteristic* characteristic,
+                                          const void* data, size_t size) {
+    os_mbuf* om = ble_hs_mbuf_from_flat(data, size);
+    if (om == nullptr) {
+        return SendResult::OutOfBuffers;
+    }
+    const int ret = ble_gatts_notify_custom(client.m_connHandle, characteristic->getHandle(), om);
+    if (ret != 0) {
+        return ret == BLE_HS_ENOMEM ? SendResult::OutOfBuffers : SendResult::Failed;
+    }
+    return SendResult::Sent;
+}
+
+Esp32BleUi::SendResult Esp32BleUi::sendPending(Client& client, size_t* sentBytes) {
+    // Load the flush flag before the buffer, all data written before the flag was set are visible then.
+    const bool flushPending = client.m_txFlushPending;
+    size_t spanSize;
+    const uint8_t* txData = client.m_txBuffer.readSpan(&spanSize);
+    const bool hasTxData = spanSize > 0 || flushPending;
+
+    // Acknowledges of several RX writes are coalesced into one notification while TX data is flowing. They are sent
+    // once the TX buffer is drained, enough data was received to keep the sender's window open or the oldest
+    // unacknowledged write waited RX_ACK_MAX_DELAY_MS.
+    // The acknowledge [acknowledged bytes: uint16 LE][credits: uint16 LE] grants the free RX buffer space. It is read
+    // after the pending bytes so data received in between is never granted twice.
+    const uint16_t rxAckBytes = client.m_rxAckPendingBytes;
+    const uint32_t now = millis();
+    if (rxAckBytes > 0 && !client.m_isRxAckDeferred) {
+        client.m_isRxAckDeferred = true;
+        client.m_rxAckDueMs = now + RX_ACK_MAX_DELAY_MS;
+    }
+    const bool isRxAckDue = rxAckBytes > 0 && (!hasTxData || rxAckBytes >= RX_ACK_COALESCE_SIZE ||
+                                               static_cast<int32_t>(now - client.m_rxAckDueMs) >= 0);
+    if (isRxAckDue || client.hasCreditUpdate()) {
+        const uint16_t rxAck[2] = {rxAckBytes, static_cast<uint16_t>(client.m_rxBuffer.free())};
+        const auto result = notify(client, m_rxAckCharacteristic, rxAck, sizeof(rxAck));
+        if (result == SendResult::Sent) {
 #ifdef VERBOSE_LOG
-                    Serial.printf("Sent %i Bytes (%i left in TX buffer) to client %i\n", sendSize, client->m_txBuffer.available(), client->m_connHandle);
+            Serial.printf("Sent RX ack (%i, %i credits) to client %i\n", rxAck[0], rxAck[1], client.m_connHandle);
 #endif
-                }
+            client.m_rxAckPendingBytes -= rxAckBytes;
+            client.m_rxAnnouncedCredits = rxAck[1];
+            client.m_isRxAckDeferred = false;
+            *sentBytes = sizeof(rxAck);
+            countTraffic(TrafficClass::Control, sizeof(rxAck));
+        }
+        return result;
+    }
+
+    const bool hasMetrics = !client.m_metricsBuffer.empty();
+    if (!hasTxData && !hasMetrics) {
+        return SendResult::Idle;
+    }
+    const auto txClass = client.m_isBulkCommandRunning ? TrafficClass::Bulk : TrafficClass::Interactive;
+    auto trafficClass = hasTxData ? txClass : TrafficClass::Metrics;
+    if (hasTxData && hasMetrics) {
+        // The class that is behind in virtual time goes first.
+        const auto passDifference = static_cast<int32_t>(client.m_trafficPass[static_cast<size_t>(txClass)] -
+                                                         client.m_trafficPass[static_cast<size_t>(TrafficClass::Metrics)]);
+        if (passDifference > 0 || (passDifference == 0 && txClass > TrafficClass::Metrics)) {
+            trafficClass = TrafficClass::Metrics;
+        }
+    }
+
+    size_t sendSize;
+    SendResult result;
+    if (trafficClass == TrafficClass::Metrics) {
+        const uint8_t* metricsData = client.m_metricsBuffer.readSpan(&spanSize);
+        sendSize = std::min(client.chunkSize(), spanSize);
+        result = notify(client, m_uiCharacteristic, metricsData, sendSize);
+        if (result == SendResult::Sent) {
+            client.m_metricsBuffer.pop(sendSize);
+            if (client.m_hasMetricsActivity.exchange(false)) {
+                client.m_lastActivityMs = millis();
+            }
+            if (client.m_hasMetricsBacklog && m_metricsTask) {
+                xTaskNotifyGive(m_metricsTask);
             }
-            dataToSend |= client->m_txBuffer.available() || client->m_txBuffer.shouldFlush() || client->m_rxAckPendingBytes;
-            // Serial.printf("%i %i %i %i %i\n", client->m_txBuffer.available(), client->m_rxAckPendingBytes, rxAckSendRet, txRet, dataToSend);
         }
+    } else {
+        sendSize = std::min(client.chunkSize(), spanSize);
+        result = notify(client, m_txCharacteristic, txData, sendSize);
+        if (result == SendResult::Sent) {
+            client.m_txBuffer.pop(sendSize);
+            if (sendSize == 0) {
+                client.m_txFlushPending = false;
+            }
+            client.notifyTxTaken();
+#ifdef VERBOSE_LOG
+            Serial.printf("Sent %i Bytes (%i left in TX buffer) to client %i\n", sendSize,
+                          client.m_txBuffer.available(), client.m_connHandle);
+#endif
+        }
+    }
+    if (result != SendResult::Sent) {
+        return result;
     }
+    *sentBytes = sendSize;
+    countTraffic(trafficClass, sendSize);
+
+    uint32_t& pass = client.m_trafficPass[static_cast<size_t>(trafficClass)];
+    pass += sendSize * TRAFFIC_PASS_SCALE / getTrafficWeight(trafficClass);
+    // Classes without data are pulled along, so they can not save up virtual time for a later burst.
+    for (size_t i = static_cast<size_t>(TrafficClass::Interactive); i < TrafficClassCount; ++i) {
+        const auto otherClass = static_cast<TrafficClass>(i);
+        const bool hasData = (otherClass == txClass && hasTxData) || (otherClass == TrafficClass::Metrics && hasMetrics);
+        if (!hasData && static_cast<int32_t>(client.m_trafficPass[i] - pass) < 0) {
+            client.m_trafficPass[i] = pass;
+        }
+    }
+    return SendResult::Sent;
 }
 
 void Esp32BleUi::processMetrics() {
+    uint32_t lastFlushMs = millis();
+    uint32_t lastAdvertisementUpdateMs = millis() - AdvertisementUpdateIntervalMs;
     while (true) {
-        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000000));
-
-        std::unique_lock<std::mutex> metricsLock{m_metricsMutex};
-
-        auto it = m_changedMetrics.getEntries().begin();
-        while (it != m_changedMetrics.getEntries().end()) {
-            auto& metric = *it->second;
-            size_t metricSize;
-            size_t writtenSize = metric.writeToBuffer(
-                m_changedMetricsBuffer.tail(), m_changedMetricsBuffer.free(), &metricSize
-            );
-            m_changedMetricsBuffer.push(writtenSize);
-            if (metricSize > m_changedMetricsBuffer.capacity()) {
-                log_e("Metric '%s' does not fit in buffer (%i > %i)\n", metric.name(), metricSize,
-                      m_changedMetricsBuffer.capacity());
-                ++it;
-                continue;
+        TickType_t waitTicks = portMAX_DELAY;
+        if (m_isAdvertisementDirty) {
+            const uint32_t sinceLastUpdateMs = millis() - lastAdvertisementUpdateMs;
+            waitTicks = sinceLastUpdateMs >= AdvertisementUpdateIntervalMs
+                            ? 0
+                            : pdMS_TO_TICKS(AdvertisementUpdateIntervalMs - sinceLastUpdateMs);
+        }
+        if (ulTaskNotifyTake(pdTRUE, waitTicks) > 0) {
+            // Changes arriving until the next flush is due only set their bit again.
+            const uint32_t flushIntervalMs = m_metricsFlushIntervalMs;
+            const uint32_t sinceLastFlushMs = millis() - lastFlushMs;
+            if (sinceLastFlushMs < flushIntervalMs) {
+                vTaskDelay(pdMS_TO_TICKS(flushIntervalMs - sinceLastFlushMs));
             }
-            if (writtenSize == 0) {
-                processChangedMetricsBuffer();
-            } else {
-                ++it;
+            lastFlushMs = millis();
+            if (flushChangedMetrics()) {
+                m_isAdvertisementDirty = true;
             }
         }
-        processChangedMetricsBuffer();
-        m_changedMetrics.clear();
+        if (m_isAdvertisementDirty && millis() - lastAdvertisementUpdateMs >= AdvertisementUpdateIntervalMs) {
+            m_isAdvertisementDirty = false;
+            updateAdvertisement();
+            lastAdvertisementUpdateMs = millis();
+        }
     }
 }
 
-void Esp32BleUi::processChangedMetricsBuffer() {
-    while (!m_changedMetricsBuffer.empty()) {
-        size_t sendSize = std::min(BLE_CHUNK_SIZE, m_changedMetricsBuffer.available());
-        bool sendFailure = false;
+bool Esp32BleUi::flushChangedMetrics() {
+    std::bitset<MaximumMetrics> dirtyMetrics;
+    for (size_t word = 0; word < MaximumMetrics / 32; ++word) {
+        const uint32_t bits = m_dirtyMetrics[word].exchange(0);
+        for (size_t bit = 0; bit < 32; ++bit) {
+            if (bits & (1u << bit)) {
+                dirtyMetrics.set(word * 32 + bit);
+            }
+        }
+    }
+    std::vector<std::shared_ptr<const KeyValueStore::Value> > overflowMetrics;
+    {
+        std::unique_lock<std::mutex> overflowMetricsLock{m_overflowMetricsMutex};
+        overflowMetrics.swap(m_overflowMetrics);
+    }
+    std::vector<std::shared_ptr<Client> > clients;
+    {
         std::unique_lock<std::mutex> clientsLock{m_clientsMutex};
-        for (const auto& client: m_clients) {
-            os_mbuf* om = ble_hs_mbuf_from_flat(m_changedMetricsBuffer.data(), sendSize);
-            if (om == nullptr) {
-                sendFailure = true;
-                break;
+        clients = m_clients;
+    }
+    // The profile is published as a metric itself, its changes would otherwise keep every connection active.
+    auto activityMetrics = dirtyMetrics;
+    if (m_profileMetric && m_profileMetric->index() < MaximumMetrics) {
+        activityMetrics.reset(m_profileMetric->index());
+    }
+    const bool isActivity = activityMetrics.any() || !overflowMetrics.empty();
+    for (auto& client: clients) {
+        client->m_pendingMetrics |= dirtyMetrics;
+        if (isActivity) {
+            client->m_hasMetricsActivity = true;
+        }
+        auto& pendingOverflowMetrics = client->m_pendingOverflowMetrics;
+        for (const auto& metric: overflowMetrics) {
+            if (std::find(pendingOverflowMetrics.begin(), pendingOverflowMetrics.end(), metric) ==
+                pendingOverflowMetrics.end()) {
+                pendingOverflowMetrics.push_back(metric);
             }
-            if (ble_gatts_notify_custom(client->m_connHandle, m_uiCharacteristic->getHandle(), om) != 0) {
-                sendFailure = true;
-                break;
+        }
+    }
+    // Every client has its own queue, a stalled client only delays its own updates.
+    for (auto& client: clients) {
+        encodePendingMetrics(*client);
+    }
+    xTaskNotifyGive(m_txTask);
+    return dirtyMetrics.any() || !overflowMetrics.empty();
+}
+
+bool Esp32BleUi::addAdvertisedValue(const char* name) {
+    if (!m_metrics) {
+        return false;
+    }
+    auto value = m_metrics->findValue(name);
+    if (!value) {
+        return false;
+    }
+    {
+        std::unique_lock<std::mutex> advertisementLock{m_advertisementMutex};
+        m_advertisedValues.emplace_back(std::move(value));
+    }
+    m_isAdvertisementDirty = true;
+    xTaskNotifyGive(m_metricsTask);
+    return true;
+}
+
+void Esp32BleUi::updateAdvertisement() {
+    const std::string hostname = m_cli->getHostname();
+    // The scan response holds at most 31 bytes: the name and manufacturer data, each with a 2 byte AD header, the
+    // latter starting with the company id. The name is shortened so at least the summary header fits.
+    constexpr size_t summaryHeaderSize = 6;
+    constexpr size_t maximumNameSize = 31 - 2 - 2 - 2 - summaryHeaderSize;
+    const size_t nameSize = std::min(hostname.size(), maximumNameSize);
+    const size_t manufacturerDataSize = 31 - 2 - nameSize - 2;
+
+    uint16_t configHash = 0;
+    if (m_metrics) {
+        std::vector<size_t> advertisedIndices;
+        {
+            std::unique_lock<std::mutex> advertisementLock{m_advertisementMutex};
+            advertisedIndices.reserve(m_advertisedValues.size());
+            for (const auto& value: m_advertisedValues) {
+                advertisedIndices.push_back(value->index());
             }
         }
-        if (!sendFailure) {
-            m_changedMetricsBuffer.pop(sendSize);
-        } else {
-            delay(20);
+        uint32_t crc = 0;
+        uint8_t record[METRIC_RECORD_SIZE];
+        m_metrics->forEachValue([&crc, &record, &advertisedIndices](const std::shared_ptr<const KeyValueStore::Value>& value) {
+            if (value->isPersistent() &&
+                std::find(advertisedIndices.begin(), advertisedIndices.end(), value->index()) == advertisedIndices.end()) {
+                const size_t recordSize = value->writeToBuffer(record, sizeof(record));
+                crc = esp_rom_crc32_le(crc, record, recordSize);
+            }
+        });
+        configHash = static_cast<uint16_t>(crc);
+    }
+    const esp_app_desc_t* appDescription = esp_ota_get_app_description();
+
+    std::string data;
+    data.reserve(manufacturerDataSize);
+    data += '\xff';
+    data += '\xff';
+    data += static_cast<char>(AdvertisementVersion);
+    data += '\0';
+    data += static_cast<char>(appDescription->app_elf_sha256[0]);
+    data += static_cast<char>(appDescription->app_elf_sha256[1]);
+    data += static_cast<char>(configHash & 0xff);
+    data += static_cast<char>(configHash >> 8);
+    {
+        std::unique_lock<std::mutex> advertisementLock{m_advertisementMutex};
+        uint8_t valueBuffer[METRIC_RECORD_SIZE];
+        for (const auto& value: m_advertisedValues) {
+            const size_t valueSize = value->writeValueToBuffer(valueBuffer, sizeof(valueBuffer));
+            if (valueSize == 0 || value->index() >= MaximumMetrics ||
+                data.size() + 1 + valueSize > manufacturerDataSize) {
+                data[3] = static_cast<char>(data[3] | AdvertisementValuesTruncated);
+                continue;
+            }
+            data += static_cast<char>(value->index());
+            data.append(reinterpret_cast<const char*>(valueBuffer), valueSize);
         }
     }
+    if (data == m_scanResponseManufacturerData) {
+        return;
+    }
+    m_scanResponseManufacturerData = data;
+
+    NimBLEAdvertisementData scanResponse;
+    if (nameSize < hostname.size()) {
+        scanResponse.setShortName(hostname.substr(0, nameSize));
+    } else {
+        scanResponse.setName(hostname);
+    }
+    scanResponse.setManufacturerData(data);
+    NimBLEDevice::getAdvertising()->setScanResponseData(scanResponse);
 }
 
-void Esp32BleUi::runClient(void* arg) {
-    const auto clientPtr = static_cast<std::shared_ptr<Client>*>(arg);
-    auto client = *clientPtr;
-    delete clientPtr;
+void Esp32BleUi::encodePendingMetrics(Client& client) {
+    if (client.m_metricsResyncRequested.exchange(false)) {
+        client.m_announcedMetrics.reset();
+        // Indices without a value are skipped while encoding.
+        client.m_pendingMetrics.set();
+        client.m_pendingOverflowMetrics.clear();
+        m_metrics->forEachValue([&client](const std::shared_ptr<const KeyValueStore::Value>& value) {
+            if (value->index() >= MaximumMetrics) {
+                client.m_pendingOverflowMetrics.push_back(value);
+            }
+        });
+    }
+    const bool useDictionary = client.m_metricsDictionaryRequested;
+    if (useDictionary != client.m_useMetricsDictionary) {
+        client.m_useMetricsDictionary = useDictionary;
+        client.m_announcedMetrics.reset();
+    }
 
-    client->setTimeout(1000 * 60 * 60 * 24);
-    client->executeCommandLine(Client::ExecType::Blocking);
+    uint8_t record[METRIC_RECORD_SIZE];
+    for (size_t i = 0; i < MaximumMetrics && client.m_pendingMetrics.any(); ++i) {
+        const size_t index = (client.m_nextPendingMetric + i) % MaximumMetrics;
+        if (!client.m_pendingMetrics[index]) {
+            continue;
+        }
+        const auto metric = m_metrics->getValue(index);
+        if (metric) {
+            size_t metricSize;
+            const size_t writtenSize = encodeMetric(client, *metric, record, sizeof(record), &metricSize);
+            if (writtenSize == 0) {
+                log_e("Metric '%s' does not fit in buffer (%i > %i)\n", metric->name(), metricSize, sizeof(record));
+            } else if (client.m_metricsBuffer.free() < writtenSize) {
+                client.m_nextPendingMetric = index;
+                break;
+            } else {
+                client.m_metricsBuffer.push(record, writtenSize);
+                if (record[0] == MetricDefineRecord) {
+                    client.m_announcedMetrics.set(index);
+                }
+            }
+        }
+        client.m_pendingMetrics.reset(index);
+    }
 
-    client.reset();
-    vTaskDelete(nullptr);
+    auto& overflowMetrics = client.m_pendingOverflowMetrics;
+    if (client.m_useMetricsDictionary) {
+        if (!overflowMetrics.empty() && !m_hasDroppedMetrics.exchange(true)) {
+            log_e("Metric '%s' exceeds the maximum of %i metrics in dictionary mode", overflowMetrics.front()->name(),
+                  MaximumMetrics);
+        }
+        overflowMetrics.clear();
+    } else if (client.m_pendingMetrics.none()) {
+        size_t encodedCount = 0;
+        for (; encodedCount < overflowMetrics.size(); ++encodedCount) {
+            const auto& metric = *overflowMetrics[encodedCount];
+            size_t metricSize;
+            const size_t writtenSize = metric.writeToBuffer(record, sizeof(record), &metricSize);
+            if (writtenSize == 0) {
+                log_e("Metric '%s' does not fit in buffer (%i > %i)\n", metric.name(), metricSize, sizeof(record));
+            } else if (client.m_metricsBuffer.free() < writtenSize) {
+                break;
+            } else {
+                client.m_metricsBuffer.push(record, writtenSize);
+            }
+        }
+        overflowMetrics.erase(overflowMetrics.begin(), overflowMetrics.begin() + encodedCount);
+    }
+    client.m_hasMetricsBacklog = client.m_pendingMetrics.any() || !overflowMetrics.empty();
+}
+
+size_t Esp32BleUi::encodeMetric(const Client& client, const KeyValueStore::Value& metric, uint8_t* buffer,
+                                size_t bufferSize, size_t* requiredBufferSize) {
+    if (!client.m_useMetricsDictionary) {
+        return metric.writeToBuffer(buffer, bufferSize, requiredBufferSize);
+    }
+    const size_t id = metric.index();
+    const bool isAnnounced = client.m_announcedMetrics[id];
+    buffer[0] = isAnnounced ? MetricValueRecord : MetricDefineRecord;
+    buffer[1] = static_cast<uint8_t>(id);
+    size_t writtenSize;
+    if (isAnnounced) {
+        writtenSize = metric.writeValueToBuffer(buffer + 2, bufferSize - 2, requiredBufferSize);
+    } else {
+        writtenSize = metric.writeToBuffer(buffer + 2, bufferSize - 2, requiredBufferSize);
+    }
+    if (requiredBufferSize != nullptr) {
+        *requiredBufferSize += 2;
+    }
+    return writtenSize > 0 ? writtenSize + 2 : 0;
 }
@@ -18,7 +18,11 @@
 
 #pragma once
 
+#include "Esp32Cli/BinaryCommand.h"
 #include "Esp32Cli/CommandContainer.h"
+#include "Esp32Cli/CommandTrace.h"
+#include "Esp32Cli/DispatchTable.h"
+#include "Esp32Cli/Executor.h"
 
 #include <Arduino.h>
 #include <map>
@@ -39,12 +43,46 @@ public:
 
     void setFirmwareInfo(std::string firmwareInfo);
 
+    using CommandContainer::addCommand;
+
+    void addCommand(const char* name, std::unique_ptr<Command> command) override;
+
+    /**
+     * Build a @link DispatchTable for all commands registered so far and use it for dispatching and help listings.
+     * Adding a command to the Cli drops the table again. Commands added to groups after freezing are not found.
+     */
+    void freeze();
+
     void executeCommand(Stream& io, std::vector<std::string>& argv, const std::shared_ptr<Client>& client = nullptr) const;
 
+    void executeCommand(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client = nullptr) const;
+
+    template<
+            typename CommandT,
+            typename... Args
+    >
+    void addBinaryCommand(uint8_t type, Args&& ... args) {
+        addBinaryCommand(type, std::unique_ptr<CommandT>(new CommandT(std::forward<Args>(args)...)));
+    }
+
+    void addBinaryCommand(uint8_t type, std::unique_ptr<BinaryCommand> command);
+
+    void executeBinaryCommand(Stream& io, uint8_t type, const uint8_t* payload, size_t size,
+                              const std::shared_ptr<Client>& client = nullptr) const;
+
+    /**
+     * Let a worker of the shared @link Executor execute the pending input of the client.
+     */
+    void schedule(const std::shared_ptr<Client>& client) const {
+        m_executor->schedule(client);
+    }
+
     void printCommandNotFound(Print& output, const std::string& commandName) const;
 
     static void printUsage(Print& output, const std::string& commandName, const Command& command);
 
+    static void printUsage(Print& output, const ArgvView& argv, const Command& command);
+
     void printWelcome(Print& output) const;
 
     void printPrompt(Print& output) const;
@@ -54,6 +92,8 @@ public:
     }
 
 private:
+    void dispatchCommand(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const;
+
     class HelpCommand : public Command {
     public:
         explicit HelpCommand(Cli& cli) : m_cli{cli} {
@@ -67,5 +107,17 @@ private:
 
     std::string m_hostname;
     std::string m_firmwareInfo{};
+    std::vector<std::pair<uint8_t, std::unique_ptr<BinaryCommand>>> m_binaryCommands;
+    std::unique_ptr<Executor> m_executor;
+
+    /**
+     * Mutable because commands are executed via the const @link executeCommand.
+     */
+    mutable CommandTrace m_commandTrace;
+
+    /**
+     * Accessed via std::atomic_load/std::atomic_store, commands are executed from multiple tasks.
+     */
+    std::shared_ptr<const DispatchTable> m_dispatchTable;
 };
 }
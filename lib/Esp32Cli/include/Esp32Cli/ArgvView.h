@@ -0,0 +1,115 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Esp32Cli {
+/**
+ * Non-owning view of the arguments of a command line. Sub commands get a view on the same arguments with an offset,
+ * so dispatching through command groups neither copies arguments nor builds command names.
+ */
+class ArgvView {
+public:
+    /**
+     * @param argv Null terminated arguments, first entry is the command name.
+     * @param commandName Printable name replacing argv[0] in @link commandName. Can be null.
+     */
+    ArgvView(const char* const* argv, size_t argc, const char* commandName = nullptr)
+        : m_argv{argv}, m_argc{argc}, m_commandName{commandName} {
+    }
+
+    /**
+     * @return Number of arguments including the name of the current command.
+     */
+    size_t size() const {
+        return m_argc - m_offset;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @param i 0 is the name of the current command, not including parent commands.
+     */
+    const char* operator[](size_t i) const {
+        return m_argv[m_offset + i];
+    }
+
+    bool equals(size_t i, const char* value) const {
+        return strcmp((*this)[i], value) == 0;
+    }
+
+    /**
+     * @return View for the sub command named by argument 1.
+     */
+    ArgvView subCommand() const {
+        ArgvView view{*this};
+        view.m_offset++;
+        return view;
+    }
+
+    /**
+     * @return View for a command line nested in the arguments, starting with the command name at argument i.
+     */
+    ArgvView nestedCommand(size_t i) const {
+        return ArgvView{m_argv + m_offset + i, size() - i};
+    }
+
+    /**
+     * Print the name of the current command including parent commands.
+     */
+    void printCommandName(Print& output) const {
+        output.print(m_commandName != nullptr ? m_commandName : m_argv[0]);
+        for (size_t i = 1; i <= m_offset; i++) {
+            output.print(' ');
+            output.print(m_argv[i]);
+        }
+    }
+
+    /**
+     * @return Name of the current command including parent commands.
+     */
+    std::string commandName() const {
+        std::string name{m_commandName != nullptr ? m_commandName : m_argv[0]};
+        for (size_t i = 1; i <= m_offset; i++) {
+            name += ' ';
+            name += m_argv[i];
+        }
+        return name;
+    }
+
+    /**
+     * @return Copy of the arguments starting with the name of the current command.
+     */
+    std::vector<std::string> toVector() const {
+        return {m_argv + m_offset, m_argv + m_argc};
+    }
+
+private:
+    const char* const* m_argv;
+    size_t m_argc;
+    size_t m_offset{0};
+    const char* m_commandName;
+};
+}
@@ -0,0 +1,48 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+
+namespace Esp32Cli {
+
+class Client;
+
+/**
+ * Command received as a binary frame instead of a text command line. See @link Client::BinaryFrameStart for the frame
+ * format.
+ */
+class BinaryCommand {
+public:
+    BinaryCommand() = default;
+    BinaryCommand(const BinaryCommand&) = delete;
+
+    virtual ~BinaryCommand() = default;
+
+    /**
+     * Execute the command.
+     * @param io Command output
+     * @param payload Frame payload. Not aligned.
+     * @param size Size of the payload in bytes.
+     * @param client Client this execution comes from. Can be null if the command was not executed by an external client.
+     */
+    virtual void execute(Stream& io, const uint8_t* payload, size_t size, const std::shared_ptr<Client>& client) const = 0;
+};
+}
@@ -18,12 +18,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <list>
 
 #include "Esp32Cli.h"
 
 namespace Esp32Cli {
 class Client : public Stream, public std::enable_shared_from_this<Client> {
+    friend class Executor;
+
 public:
     enum class ExecType {
         Blocking,
@@ -37,7 +43,26 @@ public:
      */
     static constexpr size_t MaximumArgvSize = 2048;
 
-    explicit Client(std::shared_ptr<Cli> cli) : m_cli{std::move(cli)} {
+    /**
+     * Maximum number of arguments of a command including the command name.
+     */
+    static constexpr size_t MaximumArgc = 32;
+
+    /**
+     * Start of a binary command frame. A frame may start wherever a command may start and has the format
+     * [0x02][type: uint8][payload size: uint8][payload], it is executed via @link Cli::executeBinaryCommand. Line breaks
+     * directly following a frame are ignored.
+     */
+    static constexpr char BinaryFrameStart = 0x02;
+
+    explicit Client(std::shared_ptr<Cli> cli) : m_cli{std::move(cli)}, m_id{nextId()} {
+    }
+
+    /**
+     * @return Numeric id of the client, unique for the lifetime of the firmware apart from overflows. Never 0.
+     */
+    uint16_t getId() const {
+        return m_id;
     }
 
     /**
@@ -49,10 +74,44 @@ public:
      *
      * Lines starting with # will be ignored.
      *
+     * Binary command frames (see @link BinaryFrameStart) can be mixed with text commands.
+     *
      * @param execType Non-blocking returns immediately if no more data are available for read.
      */
     virtual void executeCommandLine(ExecType execType);
 
+    /**
+     * @return True if the client is queued or running on the @link Executor.
+     */
+    bool isScheduled() const {
+        return m_isScheduled;
+    }
+
+    /**
+     * @return True while a worker of the @link Executor uses the client. Unlike @link isScheduled this also covers
+     * the final input check after the worker cleared the scheduled flag. Transports must not tear down a client
+     * while it is scheduled or executing.
+     */
+    bool isExecuting() const {
+        return m_executingWorkers > 0;
+    }
+
+    /**
+     * @return True if @link executeCommandLine has input to process. Used by the @link Executor to decide whether the
+     * client needs to run again after its worker finished.
+     */
+    virtual bool hasPendingInput() {
+        return m_hasInputByte || available() > 0;
+    }
+
+    /**
+     * Mark the running command as tagged. Its output is delimited by @link FramedStream frames, so the client does not
+     * need to mark the end of the command output itself. Reset when the command ends.
+     */
+    void setCommandTagged() {
+        m_isCommandTagged = true;
+    }
+
     void addDisconnectEventListener(void* owner, std::function<void()> callback) {
         m_onDisconnectEventHandlers.emplace_back(owner, std::move(callback));
     }
@@ -69,6 +128,32 @@ public:
     }
 
 protected:
+    /**
+     * Borrow buffered input without consuming it. The returned span stays valid until the next call to
+     * @link consumeInput. Blocks for blocking execution until at least one byte is available.
+     *
+     * The default implementation reads a single byte via read(). Implementations with an internal buffer should
+     * override this together with @link consumeInput to let the parser scan the buffer in place.
+     *
+     * @param data Set to the start of the available input.
+     * @return Number of bytes available at data, 0 if no input is available (non-blocking) or the input ended.
+     */
+    virtual size_t borrowInput(const char** data, ExecType execType);
+
+    /**
+     * Consume the first bytes of the span returned by the last @link borrowInput call.
+     */
+    virtual void consumeInput(size_t size);
+
+    /**
+     * Execute a parsed text command. The default implementation dispatches it via the Cli.
+     */
+    virtual void executeCommand(const ArgvView& argv);
+
+    bool isCommandTagged() const {
+        return m_isCommandTagged;
+    }
+
     /**
      * Callback executed when a command finished.
      */
@@ -87,24 +172,110 @@ protected:
     std::shared_ptr<Cli> m_cli;
 
 private:
+    enum class BinaryFrameState : uint8_t {
+        None,
+        Type,
+        Size,
+        Payload,
+    };
+
+    static uint16_t nextId();
+
+    /**
+     * Feed a single byte to the parser.
+     * @return True if a complete command was parsed and can be executed via @link executeParsedCommand.
+     */
+    bool parseChar(char c);
+
+    /**
+     * Consume a byte of a binary frame.
+     * @return True if the frame is complete.
+     */
+    bool parseBinaryFrame(char c);
+
+    /**
+     * @return Number of bytes at the start of data that need no special handling by the parser and can be copied into
+     * the current argument as is.
+     */
+    size_t plainInputLength(const char* data, size_t size) const;
+
+    void executeParsedCommand();
+
+    /**
+     * Parsed arguments of the current command. Arguments are stored null terminated one after another in a fixed
+     * buffer, so parsing and dispatching a command does not allocate.
+     */
     struct ParserState {
-        std::string arg{};
-        std::vector<std::string> argv{};
+        std::array<char, MaximumArgvSize> argBuffer{};
+        std::array<const char*, MaximumArgc + 1> argv{};
+        size_t argc{0};
         size_t argvSize{0};
+        size_t argStart{0};
+        bool isArgvOverflow{false};
         bool isInQuotation{false};
         char quotationCharacter{0};
         bool isEscapeSequence{false};
         bool isComment{false};
         bool gotCommandEndOrNewLine{false};
+        BinaryFrameState binaryFrameState{BinaryFrameState::None};
+        uint8_t binaryType{0};
+        uint8_t binarySize{0};
+        bool isBinaryFrameComplete{false};
+
+        bool isArgEmpty() const {
+            return argvSize == argStart;
+        }
 
         void addCharToArg(const char c) {
-            if (argvSize > MaximumArgvSize) {
+            // Keep space for the null terminator.
+            if (argvSize + 1 >= MaximumArgvSize) {
+                isArgvOverflow = true;
                 return;
             }
-            arg.push_back(c);
-            argvSize++;
+            argBuffer[argvSize++] = c;
+        }
+
+        void addToArg(const char* data, size_t size) {
+            // Keep space for the null terminator, argvSize reaches MaximumArgvSize after terminating a full argument.
+            if (argvSize + 1 >= MaximumArgvSize) {
+                isArgvOverflow = true;
+                return;
+            }
+            if (argvSize + size >= MaximumArgvSize) {
+                isArgvOverflow = true;
+                size = MaximumArgvSize - 1 - argvSize;
+            }
+            memcpy(argBuffer.data() + argvSize, data, size);
+            argvSize += size;
+        }
+
+        void endArg() {
+            if (isArgEmpty()) {
+                return;
+            }
+            if (argc == MaximumArgc || argvSize >= MaximumArgvSize) {
+                isArgvOverflow = true;
+                argvSize = argStart;
+                return;
+            }
+            argBuffer[argvSize++] = '\0';
+            argv[argc++] = argBuffer.data() + argStart;
+            argStart = argvSize;
+        }
+
+        void clear() {
+            argc = 0;
+            argvSize = 0;
+            argStart = 0;
+            isArgvOverflow = false;
         }
     } m_parserState{};
+    uint16_t m_id;
+    char m_inputByte{0};
+    bool m_hasInputByte{false};
+    bool m_isCommandTagged{false};
+    std::atomic<bool> m_isScheduled{false};
+    std::atomic<uint8_t> m_executingWorkers{0};
     std::list<OnDisconnectEventHandlerEntry> m_onDisconnectEventHandlers;
 };
 }
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "ArgvView.h"
+
 #include <Arduino.h>
 #include <memory>
 #include <string>
@@ -26,6 +28,7 @@
 namespace Esp32Cli {
 
 class Client;
+class CommandContainer;
 
 class Command {
 public:
@@ -34,8 +37,22 @@ public:
 
     virtual ~Command() = default;
 
+    /**
+     * Execute the command. Commands either override the std::vector based overload or derive from
+     * @link ArgvCommand and override this one.
+     *
+     * The default implementation copies the arguments and calls the std::vector based overload.
+     *
+     * @param io Command input and output
+     * @param argv Command arguments. Only valid during the call. First entry is always the single name of the current
+     * command not including potential parent commands, the full name is available via @link ArgvView::commandName.
+     * @param client Client this execution comes from. Can be null if the command was not executed by an external client.
+     */
+    virtual void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const;
+
     /**
      * Execute the command.
+     *
      * @param io Command input and output
      * @param commandName Printable name for the command. Includes parent commands in case this is a sub command.
      * @param argv Command arguments. First entry is always the single name of the current command not including potential parent commands.
@@ -50,5 +67,32 @@ public:
     virtual void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const {
         printUsage(output);
     }
+
+    /**
+     * @return Sub commands this command dispatches to by name or null.
+     */
+    virtual const CommandContainer* getSubCommands() const {
+        return nullptr;
+    }
+
+protected:
+    /**
+     * Call the @link ArgvView based overload with the given arguments.
+     */
+    void executeArgvView(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+                         const std::shared_ptr<Client>& client) const;
+};
+
+/**
+ * Base for commands working on an @link ArgvView. The std::vector based overload forwards to it.
+ */
+class ArgvCommand : public Command {
+public:
+    void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const override = 0;
+
+    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+                 const std::shared_ptr<Client>& client) const final {
+        executeArgvView(io, commandName, argv, client);
+    }
 };
 }
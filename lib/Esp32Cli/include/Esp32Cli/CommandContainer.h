@@ -38,10 +38,14 @@ public:
         addCommand(name, std::unique_ptr<CommandT>(new CommandT(std::forward<Args>(args)...)));
     }
 
-    void addCommand(const char* name, std::unique_ptr<Command> command) {
+    virtual void addCommand(const char* name, std::unique_ptr<Command> command) {
         m_commands.set(name, std::move(command));
     }
 
+    const std::vector<LightweightMap<std::unique_ptr<Command>>::entry_t>& getCommandEntries() const {
+        return m_commands.getEntries();
+    }
+
 protected:
     const Command* getCommand(const char* name) const {
         auto it = m_commands.find(name);
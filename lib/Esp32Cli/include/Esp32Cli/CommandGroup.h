@@ -26,13 +26,19 @@
 
 namespace Esp32Cli {
 
-class CommandGroup : public Command, protected CommandContainer {
+class CommandGroup : public ArgvCommand, protected CommandContainer {
 public:
-    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv, const std::shared_ptr<Client>& client) const override;
+    using ArgvCommand::execute;
+
+    void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const override;
 
     void printUsage(Print& output) const override;
 
     void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override;
+
+    const CommandContainer* getSubCommands() const override {
+        return this;
+    }
 };
 
 }
@@ -0,0 +1,85 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "ArgvView.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Esp32Cli {
+/**
+ * Ring of recently executed commands with start time, duration and client. Disabled by default, recording only
+ * costs a relaxed atomic load then.
+ */
+class CommandTrace {
+public:
+    static constexpr size_t DefaultCapacity = 64;
+
+    static constexpr size_t MaximumCapacity = 1024;
+
+    /**
+     * Maximum length of the recorded command line, longer command lines are truncated.
+     */
+    static constexpr size_t MaximumCommandLength = 47;
+
+    struct Entry {
+        uint32_t startMs;
+        uint32_t durationUs;
+        uint16_t clientId;
+        bool isTruncated;
+        char commandLine[MaximumCommandLength + 1];
+    };
+
+    bool isEnabled() const {
+        return m_isEnabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Start recording into a ring of the given capacity. Drops recorded entries if the capacity changes.
+     */
+    void enable(size_t capacity);
+
+    void disable();
+
+    void clear();
+
+    /**
+     * @param clientId Id of the client executing the command, 0 for internal executions.
+     */
+    void record(const ArgvView& argv, uint16_t clientId, uint32_t startMs, uint32_t durationUs);
+
+    /**
+     * Print the entries from oldest to newest, one per line: start_ms duration_us client_id truncated command_line.
+     * Truncated is T for truncated command lines, - otherwise. Only outermost executions are recorded, replay-trace.sh
+     * feeds a dump back to a device with the original timing.
+     */
+    void dump(Print& output) const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+    size_t m_next{0};
+    size_t m_size{0};
+    std::atomic<bool> m_isEnabled{false};
+};
+}
@@ -20,6 +20,7 @@
 
 #include "Command.h"
 #include "CommandGroup.h"
+#include "CommandTrace.h"
 
 namespace Esp32Cli {
 class Cli;
@@ -34,6 +35,33 @@ private:
     Cli& m_cli;
 };
 
+/**
+ * Execute a command with its output wrapped into frames carrying the given tag, see @link FramedStream.
+ */
+class TagCommand : public ArgvCommand {
+public:
+    explicit TagCommand(Cli& cli) : m_cli{cli} {}
+
+    using ArgvCommand::execute;
+
+    void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const override;
+
+    void printUsage(Print& output) const override {
+        output.println("<tag> <command> [args...]");
+    }
+
+private:
+    Cli& m_cli;
+};
+
+/**
+ * Control and export the @link CommandTrace of the Cli.
+ */
+class TraceCommand : public CommandGroup {
+public:
+    explicit TraceCommand(CommandTrace& commandTrace);
+};
+
 class MemCommand : public Command {
 public:
     void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv, const std::shared_ptr<Client>& client) const override;
@@ -47,7 +75,7 @@ public:
 #if ESP32_CLI_ENABLE_TELNET
 class IpCommand : public Command {
 public:
-    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv) override;
+    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv, const std::shared_ptr<Client>& client) const override;
 };
 #endif
 
@@ -0,0 +1,82 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Command.h"
+
+#include <memory>
+#include <vector>
+
+namespace Esp32Cli {
+class CommandContainer;
+
+/**
+ * Immutable lookup table for a complete command tree. Each command group gets its own perfect hash table, so resolving
+ * a (sub) command name takes one hash and one string compare per nesting level.
+ *
+ * Command groups are assumed to only dispatch to their sub commands by name, a table has to be rebuilt after commands
+ * were added anywhere in the tree.
+ */
+class DispatchTable {
+public:
+    using index_t = uint16_t;
+
+    static constexpr index_t RootNode = 0;
+    static constexpr index_t InvalidNode = 0xffff;
+
+    struct Node {
+        const char* name;
+        const Command* command;
+
+        /**
+         * Children are stored consecutively, sorted by name.
+         */
+        index_t firstChild;
+        index_t childCount;
+
+        /**
+         * Perfect hash table of the children: Slot values are child offsets + 1, 0 marks an empty slot.
+         */
+        uint32_t seed;
+        index_t firstSlot;
+        index_t slotMask;
+    };
+
+    explicit DispatchTable(const CommandContainer& root);
+
+    /**
+     * @return Index of the child of parent with the given name or @link InvalidNode.
+     */
+    index_t find(index_t parent, const char* name) const;
+
+    const Node& node(index_t index) const {
+        return m_nodes[index];
+    }
+
+private:
+    static uint32_t hash(uint32_t seed, const char* name);
+
+    void addChildren(index_t parent, const CommandContainer& container);
+
+    void buildHashTable(Node& node);
+
+    std::vector<Node> m_nodes;
+    std::vector<uint8_t> m_slots;
+};
+}
@@ -0,0 +1,98 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef ESP32_CLI_EXECUTOR_WORKERS
+#define ESP32_CLI_EXECUTOR_WORKERS 2
+#endif
+
+#ifndef ESP32_CLI_EXECUTOR_MAXIMUM_WORKERS
+#define ESP32_CLI_EXECUTOR_MAXIMUM_WORKERS 6
+#endif
+
+#ifndef ESP32_CLI_EXECUTOR_STACK_SIZE
+#define ESP32_CLI_EXECUTOR_STACK_SIZE 4096
+#endif
+
+namespace Esp32Cli {
+class Client;
+
+/**
+ * Runs the pending input of all clients on a small fixed pool of worker tasks instead of one task per client.
+ *
+ * Transports call @link schedule whenever new input arrived. A worker then parses and executes the input of that
+ * client non-blocking until no more input is available. Commands that wait for more input (e.g. fs write) keep
+ * occupying their worker until they are done. So such clients do not starve the others, a client scheduled while all
+ * workers are busy gets an additional worker, up to ESP32_CLI_EXECUTOR_MAXIMUM_WORKERS. Additional workers exit
+ * again after @link IdleWorkerTimeoutMs without work.
+ */
+class Executor {
+public:
+    /**
+     * Maximum number of clients waiting for a worker. Each client is queued at most once.
+     */
+    static constexpr size_t QueueLength = 16;
+
+    static constexpr uint32_t IdleWorkerTimeoutMs = 10000;
+
+    explicit Executor(size_t workerCount = ESP32_CLI_EXECUTOR_WORKERS,
+                      size_t maximumWorkerCount = ESP32_CLI_EXECUTOR_MAXIMUM_WORKERS,
+                      uint32_t stackSize = ESP32_CLI_EXECUTOR_STACK_SIZE);
+
+    ~Executor();
+
+    /**
+     * Queue the client for execution of its pending input. Does nothing if the client is already queued or running.
+     * Does not block, so it may be called from transport callbacks.
+     */
+    void schedule(const std::shared_ptr<Client>& client);
+
+private:
+    [[noreturn]] void work();
+
+    static void startWork(void* arg) {
+        static_cast<Executor*>(arg)->work();
+    }
+
+    /**
+     * Start another worker unless the maximum number of workers is running.
+     */
+    void startWorker();
+
+    /**
+     * @return True if the calling worker is an additional one and was removed, it has to delete its task then.
+     */
+    bool removeIdleWorker();
+
+    QueueHandle_t m_queue;
+    size_t m_workerCount;
+    size_t m_maximumWorkerCount;
+    uint32_t m_stackSize;
+    std::atomic<size_t> m_idleWorkers{0};
+    std::mutex m_workersMutex;
+    std::vector<TaskHandle_t> m_workers;
+};
+}
@@ -0,0 +1,89 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <Arduino.h>
+#include <array>
+
+namespace Esp32Cli {
+/**
+ * Stream wrapping the output of a tagged command into frames, so responses of pipelined commands can be told apart.
+ *
+ * Each frame has the format [0x1e][tag: uint16 LE][payload size: uint8][payload]. A frame with an empty payload
+ * marks the end of the output of the tagged command. Reads are forwarded to the wrapped stream unchanged.
+ */
+class FramedStream : public Stream {
+public:
+    static constexpr uint8_t FrameStart = 0x1e;
+
+    static constexpr size_t HeaderSize = 4;
+
+    static constexpr size_t MaximumPayloadSize = 128;
+
+    FramedStream(Stream& stream, uint16_t tag) : m_stream{stream}, m_tag{tag} {
+    }
+
+    size_t write(uint8_t value) override {
+        return write(&value, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    int availableForWrite() override {
+        return static_cast<int>(MaximumPayloadSize - m_payloadSize);
+    }
+
+    /**
+     * Send the buffered output as a frame and flush the wrapped stream.
+     */
+    void flush() override;
+
+    /**
+     * Send the buffered output followed by the end frame.
+     */
+    void end();
+
+    int available() override {
+        return m_stream.available();
+    }
+
+    int read() override {
+        return m_stream.read();
+    }
+
+    int peek() override {
+        return m_stream.peek();
+    }
+
+    using Stream::readBytes;
+
+    size_t readBytes(char* buffer, size_t length) override {
+        return m_stream.readBytes(buffer, length);
+    }
+
+private:
+    void writeFrame();
+
+    Stream& m_stream;
+    uint16_t m_tag;
+    std::array<uint8_t, MaximumPayloadSize> m_payload{};
+    size_t m_payloadSize{0};
+};
+}
@@ -22,6 +22,9 @@
 #include "Command.h"
 #include "CommandGroup.h"
 
+#include <list>
+#include <mutex>
+
 #if ESP32_CLI_ENABLE_FS_COMMANDS
 
 namespace Esp32Cli {
@@ -29,6 +32,16 @@ class Cli;
 
 class ScriptCommand : public Command {
 public:
+    /**
+     * Maximum number of scripts kept parsed in memory.
+     */
+    static constexpr size_t MaximumCachedScripts = 8;
+
+    /**
+     * Larger scripts are executed from the file on each run and not cached.
+     */
+    static constexpr size_t MaximumCachedScriptSize = 4096;
+
     explicit ScriptCommand(std::shared_ptr<Cli> cli) : m_cli{std::move(cli)} {}
 
     void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv, const std::shared_ptr<Client>& client) const override;
@@ -38,9 +51,48 @@ public:
     void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override;
 
 private:
+    /**
+     * Commands of a script file, tokenized by the first run of the script. Identified by file name, modification time
+     * and size, so changed files are parsed again.
+     */
+    struct ParsedScript {
+        std::string fileName;
+        time_t modificationTime;
+        off_t size;
+        /**
+         * Null terminated arguments of all commands one after another.
+         */
+        std::vector<char> argBuffer;
+        std::vector<size_t> argOffsets;
+        /**
+         * Index of the first argument in argOffsets and argument count per command.
+         */
+        std::vector<std::pair<size_t, size_t>> commands;
+    };
+
     class ScriptClient : public Client {
     public:
-        ScriptClient(std::shared_ptr<Cli> cli, const char* fileName, Stream* output);
+        static constexpr size_t BufferSize = 4096;
+
+        ScriptClient(std::shared_ptr<Cli> cli, Stream* output);
+
+        /**
+         * @return False if the file could not be opened.
+         */
+        bool open(const char* fileName);
+
+        /**
+         * Record the commands executed from the file into the script. The recording is dropped if the script cannot be
+         * replayed from the recorded commands, e.g. because commands read data from the script.
+         */
+        void startRecording(std::shared_ptr<ParsedScript> parsedScript);
+
+        /**
+         * @return The recorded script or null if the script cannot be replayed.
+         */
+        std::shared_ptr<ParsedScript> finishRecording();
+
+        void executeParsedScript(const ParsedScript& parsedScript);
 
         size_t write(const uint8_t* buffer, size_t size) override;
 
@@ -56,13 +108,44 @@ private:
 
         ~ScriptClient() override;
 
+    protected:
+        size_t borrowInput(const char** data, ExecType execType) override;
+
+        void consumeInput(size_t size) override;
+
+        void executeCommand(const ArgvView& argv) override;
+
+        void onCommandEnd() override;
+
     private:
+        /**
+         * Read the next block of the file if the buffer is exhausted.
+         * @return Number of buffered bytes not consumed yet.
+         */
+        size_t fillBuffer();
+
+        std::array<char, BufferSize> m_buffer{};
+        size_t m_bufferPosition{0};
+        size_t m_bufferSize{0};
         size_t m_bytesLeft{0};
+        size_t m_bytesConsumed{0};
         FILE* m_input{nullptr};
         Stream* m_output{nullptr};
+        std::shared_ptr<ParsedScript> m_parsedScript;
+        bool m_gotCommand{false};
     };
 
+    std::shared_ptr<const ParsedScript> findParsedScript(const char* fileName, time_t modificationTime,
+                                                         off_t size) const;
+
+    void addParsedScript(std::shared_ptr<const ParsedScript> parsedScript) const;
+
     std::shared_ptr<Cli> m_cli;
+    mutable std::mutex m_cacheMutex;
+    /**
+     * Most recently used first.
+     */
+    mutable std::list<std::shared_ptr<const ParsedScript>> m_cache;
 };
 }
 
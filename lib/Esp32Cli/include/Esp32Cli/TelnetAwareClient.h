@@ -2,6 +2,7 @@
 
 #if ESP32_CLI_ENABLE_TELNET
 
+#include <mutex>
 #include <sstream>
 
 #include "Client.h"
@@ -13,6 +14,16 @@ public:
 
     static constexpr int MaximumHistoryLength = 10;
 
+    /**
+     * Output is collected up to this size before it is sent, so command output is not sent one segment per byte.
+     */
+    static constexpr size_t OutputBufferSize = 512;
+
+    /**
+     * Maximum time output stays in the buffer, see @link flushStaleOutput.
+     */
+    static constexpr uint32_t OutputFlushDelayMs = 20;
+
     explicit TelnetAwareClient(const std::shared_ptr<Cli>& cli, std::unique_ptr<ArduinoClient> arduinoClient)
         : Client(cli),
           m_arduinoClient{std::move(arduinoClient)},
@@ -22,20 +33,85 @@ public:
 
     void executeCommandLine(ExecType execType) override;
 
+    bool hasPendingInput() override;
+
+    bool isConnected() const {
+        return m_arduinoClient->connected();
+    }
+
+    /**
+     * Close the connection and notify the disconnect listeners.
+     */
+    void disconnect();
+
+    uint32_t getBytesReceived() const {
+        return m_bytesReceived;
+    }
+
+    /**
+     * @return Bytes of command output sent, not including echo and terminal control sequences.
+     */
+    uint32_t getBytesSent() const {
+        return m_bytesSent;
+    }
+
     size_t write(uint8_t) override;
 
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    /**
+     * Send the buffered output.
+     */
+    void flush() override;
+
+    /**
+     * Send the buffered output if it is older than @link OutputFlushDelayMs. Called periodically by the server to
+     * deliver the output of long running commands.
+     */
+    void flushStaleOutput();
+
     int available() override;
 
     int read() override;
 
     int peek() override;
 
+protected:
+    void onCommandEnd() override;
+
 private:
+    /**
+     * Requires m_outputMutex to be held.
+     */
+    void flushOutput();
+
+    size_t readInput(uint8_t* buffer, size_t size);
+
+    size_t readInput(char* buffer, const size_t size) {
+        return readInput(reinterpret_cast<uint8_t*>(buffer), size);
+    }
+
     void handleTelnetCommand();
 
+    /**
+     * Read a binary frame following its start byte and execute it.
+     */
+    void executeBinaryFrame();
+
+    /**
+     * Read one byte of a binary frame, waiting for it as long as the connection is open.
+     */
+    bool readFrameByte(uint8_t& value);
+
     void overwriteLineBuffer(const std::string& line);
 
     std::unique_ptr<ArduinoClient> m_arduinoClient;
+    std::mutex m_outputMutex;
+    std::array<uint8_t, OutputBufferSize> m_outputBuffer{};
+    size_t m_outputSize{0};
+    uint32_t m_outputStartMs{0};
+    std::atomic<uint32_t> m_bytesReceived{0};
+    std::atomic<uint32_t> m_bytesSent{0};
     bool m_gotTelnetCommand{false};
     size_t m_lineBufferReadPosition{0};
     std::string m_lineBuffer{};
@@ -3,27 +3,86 @@
 #if ESP32_CLI_ENABLE_TELNET
 
 #include <WiFi.h>
+#include <mutex>
 #include "../Esp32Cli.h"
+#include "Command.h"
+#include "TelnetAwareClient.h"
 
 namespace Esp32Cli {
+/**
+ * Telnet server multiplexing the listening socket and all client sockets with select() in a single task. Commands of
+ * the clients are executed by the executor of the Cli.
+ */
 class TelnetServer {
 public:
+    static constexpr size_t MaximumClients = 4;
+
+    /**
+     * Maximum time select() waits, also the interval for sending buffered output of running commands.
+     */
+    static constexpr uint32_t PollIntervalMs = TelnetAwareClient::OutputFlushDelayMs;
+
+    struct Stats {
+        uint32_t acceptedConnections;
+        uint32_t rejectedConnections;
+        uint32_t activeConnections;
+        uint32_t bytesReceived;
+        uint32_t bytesSent;
+    };
+
     explicit TelnetServer(std::shared_ptr<Cli> cli, uint16_t port = 23);
 
     ~TelnetServer();
 
+    Stats getStats() const;
+
 private:
+    struct Session {
+        int fd;
+        std::shared_ptr<TelnetAwareClient> client;
+    };
+
     [[noreturn]] void listen();
 
     static void startListen(void* arg) {
         static_cast<TelnetServer*>(arg)->listen();
     }
 
-    static void handleClient(void* arg);
+    void acceptClient();
+
+    /**
+     * Remove the sessions whose connection is closed and that are not used by the executor.
+     */
+    void removeClosedSessions();
 
     std::shared_ptr<Cli> m_cli;
-    WiFiServer m_wiFiServer{};
+    int m_listenFd{-1};
     TaskHandle_t m_listenTask{};
+
+    /**
+     * Modified by the listen task only, the lock protects reads from other tasks.
+     */
+    mutable std::mutex m_sessionsMutex;
+    std::vector<Session> m_sessions;
+    uint32_t m_acceptedConnections{0};
+    uint32_t m_rejectedConnections{0};
+    /**
+     * Traffic of closed sessions.
+     */
+    uint32_t m_closedBytesReceived{0};
+    uint32_t m_closedBytesSent{0};
+};
+
+class TelnetCommand : public ArgvCommand {
+public:
+    explicit TelnetCommand(std::shared_ptr<TelnetServer> telnetServer) : m_telnetServer{std::move(telnetServer)} {}
+
+    using ArgvCommand::execute;
+
+    void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const override;
+
+private:
+    std::shared_ptr<TelnetServer> m_telnetServer;
 };
 }
 
@@ -18,13 +18,40 @@
 
 #include "Esp32Cli.h"
 
+#include "Esp32Cli/Client.h"
 #include "Esp32Cli/CommonCommands.h"
 #include "Esp32Cli/ScriptCommand.h"
 
 namespace Esp32Cli {
-Cli::Cli(std::string hostname, Cli::Private) : m_hostname{std::move(hostname)} {
+namespace {
+/**
+ * Nesting depth of Cli::executeCommand on the current task. Only the outermost execution is traced, nested ones (tag,
+ * z, scripts) are part of its command line already and would run twice when replaying the trace.
+ */
+thread_local uint8_t executionDepth = 0;
+
+class ExecutionDepthGuard {
+public:
+    ExecutionDepthGuard() {
+        executionDepth++;
+    }
+
+    ~ExecutionDepthGuard() {
+        executionDepth--;
+    }
+
+    bool isNested() const {
+        return executionDepth > 1;
+    }
+};
+}
+
+Cli::Cli(std::string hostname, Cli::Private)
+    : m_hostname{std::move(hostname)}, m_executor{new Executor} {
     addCommand<HelpCommand>("help", *this);
     addCommand<HostnameCommand>("hostname", *this);
+    addCommand<TagCommand>("tag", *this);
+    addCommand<TraceCommand>("trace", m_commandTrace);
     addCommand<MemCommand>("mem");
     addCommand<ResetCommand>("reset");
 #if ESP32_CLI_ENABLE_TELNET
@@ -49,19 +76,89 @@ void Cli::setFirmwareInfo(std::string firmwareInfo) {
     m_firmwareInfo = std::move(firmwareInfo);
 }
 
+void Cli::addCommand(const char* name, std::unique_ptr<Command> command) {
+    CommandContainer::addCommand(name, std::move(command));
+    std::atomic_store(&m_dispatchTable, std::shared_ptr<const DispatchTable>{});
+}
+
+void Cli::freeze() {
+    std::atomic_store(&m_dispatchTable, std::shared_ptr<const DispatchTable>{new DispatchTable{*this}});
+}
+
 void Cli::executeCommand(Stream& io, std::vector<std::string>& argv, const std::shared_ptr<Client>& client) const {
+    std::vector<const char*> argvPointers;
+    argvPointers.reserve(argv.size());
+    for (const auto& arg: argv) {
+        argvPointers.push_back(arg.c_str());
+    }
+    executeCommand(io, ArgvView{argvPointers.data(), argvPointers.size()}, client);
+}
+
+void Cli::executeCommand(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const {
     if (argv.empty()) {
         return;
     }
+    ExecutionDepthGuard depthGuard;
+    if (depthGuard.isNested() || !m_commandTrace.isEnabled()) {
+        dispatchCommand(io, argv, client);
+        return;
+    }
+
+    const uint32_t startMs = millis();
+    const uint32_t startUs = micros();
+    dispatchCommand(io, argv, client);
+    m_commandTrace.record(argv, client ? client->getId() : 0, startMs, micros() - startUs);
+}
 
-    const std::string& commandName = argv.front();
+void Cli::dispatchCommand(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const {
+    const auto dispatchTable = std::atomic_load(&m_dispatchTable);
+    if (dispatchTable) {
+        auto node = dispatchTable->find(DispatchTable::RootNode, argv[0]);
+        if (node == DispatchTable::InvalidNode) {
+            printCommandNotFound(io, argv[0]);
+            return;
+        }
+        // Resolve sub commands directly instead of going through each command group.
+        ArgvView commandArgv = argv;
+        while (commandArgv.size() > 1) {
+            const auto subCommandNode = dispatchTable->find(node, commandArgv[1]);
+            if (subCommandNode == DispatchTable::InvalidNode) {
+                break;
+            }
+            node = subCommandNode;
+            commandArgv = commandArgv.subCommand();
+        }
+        dispatchTable->node(node).command->execute(io, commandArgv, client);
+        return;
+    }
 
-    auto command = getCommand(commandName.c_str());
+    auto command = getCommand(argv[0]);
     if (command == nullptr) {
-        printCommandNotFound(io, commandName);
+        printCommandNotFound(io, argv[0]);
         return;
     }
-    command->execute(io, commandName, argv, client);
+    command->execute(io, argv, client);
+}
+
+void Cli::addBinaryCommand(uint8_t type, std::unique_ptr<BinaryCommand> command) {
+    for (auto& binaryCommand: m_binaryCommands) {
+        if (binaryCommand.first == type) {
+            binaryCommand.second = std::move(command);
+            return;
+        }
+    }
+    m_binaryCommands.emplace_back(type, std::move(command));
+}
+
+void Cli::executeBinaryCommand(Stream& io, uint8_t type, const uint8_t* payload, size_t size,
+                               const std::shared_ptr<Client>& client) const {
+    for (const auto& binaryCommand: m_binaryCommands) {
+        if (binaryCommand.first == type) {
+            binaryCommand.second->execute(io, payload, size, client);
+            return;
+        }
+    }
+    io.printf("%s: binary command 0x%02x not found\n", m_hostname.c_str(), type);
 }
 
 void Cli::printCommandNotFound(Print& output, const std::string& commandName) const {
@@ -75,6 +172,13 @@ void Cli::printUsage(Print& output, const std::string& commandName, const Comman
     command.printUsage(output);
 }
 
+void Cli::printUsage(Print& output, const ArgvView& argv, const Command& command) {
+    output.print("Usage: ");
+    argv.printCommandName(output);
+    output.print(' ');
+    command.printUsage(output);
+}
+
 void Cli::printWelcome(Print& output) const {
     output.print("Welcome to the ");
     output.print(m_hostname.c_str());
@@ -92,16 +196,27 @@ void Cli::printPrompt(Print& output) const {
 }
 
 void Cli::HelpCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv, const std::shared_ptr<Client>& client) const {
+    const auto dispatchTable = std::atomic_load(&m_cli.m_dispatchTable);
     if (argv.size() <= 1) {
         io.print("Available commands: ");
-        bool isFirst = true;
-        for (auto& command: m_cli.m_commands.getEntries()) {
-            if (isFirst) {
-                isFirst = false;
-            } else {
-                io.print(", ");
+        if (dispatchTable) {
+            const auto& root = dispatchTable->node(DispatchTable::RootNode);
+            for (DispatchTable::index_t i = 0; i < root.childCount; i++) {
+                if (i > 0) {
+                    io.print(", ");
+                }
+                io.print(dispatchTable->node(root.firstChild + i).name);
+            }
+        } else {
+            bool isFirst = true;
+            for (auto& command: m_cli.m_commands.getEntries()) {
+                if (isFirst) {
+                    isFirst = false;
+                } else {
+                    io.print(", ");
+                }
+                io.print(command.first);
             }
-            io.print(command.first);
         }
         io.println();
         io.println("Type help <command> for more information.");
@@ -109,6 +224,25 @@ void Cli::HelpCommand::execute(Stream& io, const std::string& commandName, std::
     }
 
     argv.erase(argv.begin());
+    if (dispatchTable) {
+        auto node = dispatchTable->find(DispatchTable::RootNode, argv[0].c_str());
+        if (node == DispatchTable::InvalidNode) {
+            io.printf("help: %s: no such command\n", argv[0].c_str());
+            return;
+        }
+        std::string name = argv[0];
+        while (argv.size() > 1) {
+            const auto subCommandNode = dispatchTable->find(node, argv[1].c_str());
+            if (subCommandNode == DispatchTable::InvalidNode) {
+                break;
+            }
+            node = subCommandNode;
+            name += " " + argv[1];
+            argv.erase(argv.begin());
+        }
+        dispatchTable->node(node).command->printHelp(io, name, argv);
+        return;
+    }
     const auto command = m_cli.getCommand(argv[0].c_str());
     if (command != nullptr) {
         command->printHelp(io, argv[0], argv);
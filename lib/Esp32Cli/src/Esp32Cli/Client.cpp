@@ -19,93 +19,227 @@
 #include "Esp32Cli/Client.h"
 
 namespace Esp32Cli {
+uint16_t Client::nextId() {
+    static std::atomic<uint16_t> lastId{0};
+    uint16_t id;
+    do {
+        id = ++lastId;
+    } while (id == 0);
+    return id;
+}
+
 void Client::executeCommandLine(const ExecType execType) {
     do {
-        if (execType == ExecType::NonBlocking && !available()) {
+        const char* data;
+        const size_t size = borrowInput(&data, execType);
+        if (size == 0) {
             return;
         }
-        const int res = read();
-        if (res < 0) {
-            break;
-        }
-        const char c = static_cast<char>(res);
-        if (m_parserState.isComment) {
-            if (c == '\n') {
-                m_parserState.isComment = false;
+        size_t consumed = 0;
+        bool commandComplete = false;
+        while (consumed < size && !commandComplete) {
+            if (m_parserState.isComment && m_parserState.binaryFrameState == BinaryFrameState::None) {
+                const void* lineEnd = memchr(data + consumed, '\n', size - consumed);
+                if (lineEnd == nullptr) {
+                    consumed = size;
+                    break;
+                }
+                consumed = static_cast<const char*>(lineEnd) - data;
             }
-            continue;
-        }
-        if (m_parserState.gotCommandEndOrNewLine) {
-            m_parserState.gotCommandEndOrNewLine = false;
-            if (c == '\r' || c == '\n') {
+            const size_t plainLength = plainInputLength(data + consumed, size - consumed);
+            if (plainLength > 0) {
+                m_parserState.addToArg(data + consumed, plainLength);
+                consumed += plainLength;
                 continue;
             }
+            commandComplete = parseChar(data[consumed++]);
         }
-        if (m_parserState.isEscapeSequence) {
-            switch (c) {
-                case 'n':
-                    m_parserState.addCharToArg('\n');
-                    break;
-                case 't':
-                    m_parserState.addCharToArg('\t');
-                    break;
-                case '\n':
-                    // Ignore escaped new line to allow splitting a command over multiple lines.
-                    m_parserState.gotCommandEndOrNewLine = true;
-                    break;
-                default:
-                    m_parserState.addCharToArg(c);
-                    break;
-            }
-            m_parserState.isEscapeSequence = false;
-            continue;
+        // Release the input before executing, the command might read the data following it directly.
+        consumeInput(consumed);
+        if (commandComplete) {
+            executeParsedCommand();
         }
-        if (c == '\\') {
-            m_parserState.isEscapeSequence = true;
-            continue;
+    } while (true);
+}
+
+void Client::executeCommand(const ArgvView& argv) {
+    m_cli->executeCommand(*this, argv, shared_from_this());
+}
+
+size_t Client::borrowInput(const char** data, const ExecType execType) {
+    if (!m_hasInputByte) {
+        if (execType == ExecType::NonBlocking && !available()) {
+            return 0;
         }
-        if (m_parserState.isInQuotation && c == m_parserState.quotationCharacter) {
-            m_parserState.isInQuotation = false;
-            continue;
+        const int res = read();
+        if (res < 0) {
+            return 0;
         }
-        if (!m_parserState.isInQuotation && (c == '"' || c == '\'')) {
-            m_parserState.isInQuotation = true;
-            m_parserState.quotationCharacter = c;
-            continue;
+        m_inputByte = static_cast<char>(res);
+        m_hasInputByte = true;
+    }
+    *data = &m_inputByte;
+    return 1;
+}
+
+void Client::consumeInput(const size_t size) {
+    if (size > 0) {
+        m_hasInputByte = false;
+    }
+}
+
+size_t Client::plainInputLength(const char* data, const size_t size) const {
+    if (m_parserState.binaryFrameState != BinaryFrameState::None || m_parserState.isEscapeSequence ||
+        m_parserState.gotCommandEndOrNewLine || m_parserState.isComment) {
+        return 0;
+    }
+    size_t length = 0;
+    if (m_parserState.isInQuotation) {
+        while (length < size && data[length] != '\\' && data[length] != m_parserState.quotationCharacter) {
+            length++;
         }
-        if (m_parserState.isInQuotation) {
-            m_parserState.addCharToArg(c);
-            continue;
+        return length;
+    }
+    if (m_parserState.isArgEmpty() && size > 0 && (data[0] == '#' || data[0] == BinaryFrameStart)) {
+        return 0;
+    }
+    while (length < size) {
+        switch (data[length]) {
+            case ' ':
+            case ';':
+            case '\n':
+            case '\r':
+            case '\\':
+            case '"':
+            case '\'':
+                return length;
+            default:
+                length++;
         }
+    }
+    return length;
+}
 
-        if (c == ' ') {
-            if (m_parserState.arg.empty()) {
-                continue;
-            }
-            m_parserState.argv.emplace_back(m_parserState.arg);
-            m_parserState.arg.clear();
-            continue;
+bool Client::parseChar(const char c) {
+    if (m_parserState.binaryFrameState != BinaryFrameState::None) {
+        return parseBinaryFrame(c);
+    }
+    if (m_parserState.isComment) {
+        if (c == '\n') {
+            m_parserState.isComment = false;
         }
-
-        if (m_parserState.arg.empty() && c == '#') {
-            m_parserState.isComment = true;
-            continue;
+        return false;
+    }
+    if (m_parserState.gotCommandEndOrNewLine) {
+        m_parserState.gotCommandEndOrNewLine = false;
+        if (c == '\r' || c == '\n') {
+            return false;
+        }
+    }
+    if (m_parserState.isEscapeSequence) {
+        switch (c) {
+            case 'n':
+                m_parserState.addCharToArg('\n');
+                break;
+            case 't':
+                m_parserState.addCharToArg('\t');
+                break;
+            case '\n':
+                // Ignore escaped new line to allow splitting a command over multiple lines.
+                m_parserState.gotCommandEndOrNewLine = true;
+                break;
+            default:
+                m_parserState.addCharToArg(c);
+                break;
         }
+        m_parserState.isEscapeSequence = false;
+        return false;
+    }
+    if (c == '\\') {
+        m_parserState.isEscapeSequence = true;
+        return false;
+    }
+    if (m_parserState.isInQuotation && c == m_parserState.quotationCharacter) {
+        m_parserState.isInQuotation = false;
+        return false;
+    }
+    if (!m_parserState.isInQuotation && (c == '"' || c == '\'')) {
+        m_parserState.isInQuotation = true;
+        m_parserState.quotationCharacter = c;
+        return false;
+    }
+    if (m_parserState.isInQuotation) {
+        m_parserState.addCharToArg(c);
+        return false;
+    }
+
+    if (c == ' ') {
+        m_parserState.endArg();
+        return false;
+    }
+
+    if (m_parserState.isArgEmpty() && c == '#') {
+        m_parserState.isComment = true;
+        return false;
+    }
+
+    if (m_parserState.isArgEmpty() && m_parserState.argc == 0 && c == BinaryFrameStart) {
+        m_parserState.binaryFrameState = BinaryFrameState::Type;
+        return false;
+    }
 
-        if (c == ';' || c == '\n' || c == '\r') {
-            if (!m_parserState.arg.empty()) {
-                m_parserState.argv.emplace_back(m_parserState.arg);
-                m_parserState.arg.clear();
+    if (c == ';' || c == '\n' || c == '\r') {
+        m_parserState.endArg();
+        return true;
+    }
+
+    m_parserState.addCharToArg(c);
+    return false;
+}
+
+bool Client::parseBinaryFrame(const char c) {
+    switch (m_parserState.binaryFrameState) {
+        case BinaryFrameState::Type:
+            m_parserState.binaryType = static_cast<uint8_t>(c);
+            m_parserState.binaryFrameState = BinaryFrameState::Size;
+            return false;
+        case BinaryFrameState::Size:
+            m_parserState.binarySize = static_cast<uint8_t>(c);
+            m_parserState.binaryFrameState = BinaryFrameState::Payload;
+            if (m_parserState.binarySize > 0) {
+                return false;
             }
-            m_cli->executeCommand(*this, m_parserState.argv, shared_from_this());
-            onCommandEnd();
-            m_parserState.argv.clear();
-            m_parserState.argvSize = 0;
-            m_parserState.gotCommandEndOrNewLine = true;
-            continue;
-        }
+            break;
+        case BinaryFrameState::Payload:
+            m_parserState.argBuffer[m_parserState.argvSize++] = c;
+            if (m_parserState.argvSize < m_parserState.binarySize) {
+                return false;
+            }
+            break;
+        case BinaryFrameState::None:
+            return false;
+    }
 
-        m_parserState.addCharToArg(c);
-    } while (true);
+    m_parserState.binaryFrameState = BinaryFrameState::None;
+    m_parserState.isBinaryFrameComplete = true;
+    return true;
+}
+
+void Client::executeParsedCommand() {
+    if (m_parserState.isBinaryFrameComplete) {
+        m_parserState.isBinaryFrameComplete = false;
+        m_cli->executeBinaryCommand(*this, m_parserState.binaryType,
+                                    reinterpret_cast<const uint8_t*>(m_parserState.argBuffer.data()),
+                                    m_parserState.argvSize, shared_from_this());
+    } else if (m_parserState.isArgvOverflow) {
+        printf("%s: argument list too long\n", m_parserState.argc > 0 ? m_parserState.argv[0] : "");
+    } else {
+        m_parserState.argv[m_parserState.argc] = nullptr;
+        executeCommand(ArgvView{m_parserState.argv.data(), m_parserState.argc});
+    }
+    m_parserState.clear();
+    onCommandEnd();
+    m_isCommandTagged = false;
+    m_parserState.gotCommandEndOrNewLine = true;
 }
 }
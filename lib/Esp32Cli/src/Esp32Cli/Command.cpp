@@ -0,0 +1,36 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Esp32Cli/Command.h"
+
+namespace Esp32Cli {
+void Command::execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const {
+    auto argvCopy = argv.toVector();
+    execute(io, argv.commandName(), argvCopy, client);
+}
+
+void Command::executeArgvView(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+                              const std::shared_ptr<Client>& client) const {
+    std::vector<const char*> argvPointers;
+    argvPointers.reserve(argv.size());
+    for (const auto& arg: argv) {
+        argvPointers.push_back(arg.c_str());
+    }
+    execute(io, ArgvView{argvPointers.data(), argvPointers.size(), commandName.c_str()}, client);
+}
+}
@@ -42,20 +42,19 @@ void CommandGroup::printHelp(Print& output, const std::string& commandName, std:
     }
 }
 
-void CommandGroup::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv, const std::shared_ptr<Client>& client) const {
+void CommandGroup::execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const {
     if (argv.size() < 2) {
-        Cli::printUsage(io, commandName, *this);
+        Cli::printUsage(io, argv, *this);
         return;
     }
 
-    const Command* command = getCommand(argv[1].c_str());
+    const Command* command = getCommand(argv[1]);
     if (command == nullptr) {
-        Cli::printUsage(io, commandName, *this);
+        Cli::printUsage(io, argv, *this);
         return;
     }
 
-    argv.erase(argv.begin());
-    command->execute(io, commandName + " " + argv[0], argv, client);
+    command->execute(io, argv.subCommand(), client);
 }
 
 void CommandGroup::printUsage(Print& output) const {
@@ -0,0 +1,113 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Esp32Cli/CommandTrace.h"
+
+#include <cinttypes>
+
+namespace Esp32Cli {
+namespace {
+/**
+ * Append the argument quoted if needed, so the command line can be executed again.
+ * @return False if the argument did not fit.
+ */
+bool appendArg(CommandTrace::Entry& entry, size_t& length, const char* arg) {
+    const bool needsQuotes = *arg == '\0' || strpbrk(arg, " \t;#\"'\\") != nullptr;
+    auto append = [&entry, &length](const char c) {
+        if (length == CommandTrace::MaximumCommandLength) {
+            return false;
+        }
+        entry.commandLine[length++] = c;
+        return true;
+    };
+
+    if (length > 0 && !append(' ')) {
+        return false;
+    }
+    if (needsQuotes && !append('"')) {
+        return false;
+    }
+    for (; *arg != '\0'; arg++) {
+        if ((*arg == '"' || *arg == '\\') && !append('\\')) {
+            return false;
+        }
+        if (!append(*arg)) {
+            return false;
+        }
+    }
+    return !needsQuotes || append('"');
+}
+}
+
+void CommandTrace::enable(const size_t capacity) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    if (capacity != m_entries.size()) {
+        m_entries.clear();
+        m_entries.shrink_to_fit();
+        m_entries.resize(capacity);
+        m_next = 0;
+        m_size = 0;
+    }
+    m_isEnabled = true;
+}
+
+void CommandTrace::disable() {
+    m_isEnabled = false;
+}
+
+void CommandTrace::clear() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_next = 0;
+    m_size = 0;
+}
+
+void CommandTrace::record(const ArgvView& argv, const uint16_t clientId, const uint32_t startMs,
+                          const uint32_t durationUs) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    if (m_entries.empty()) {
+        return;
+    }
+    auto& entry = m_entries[m_next];
+    entry.startMs = startMs;
+    entry.durationUs = durationUs;
+    entry.clientId = clientId;
+    entry.isTruncated = false;
+    size_t length = 0;
+    for (size_t i = 0; i < argv.size(); i++) {
+        if (!appendArg(entry, length, argv[i])) {
+            entry.isTruncated = true;
+            break;
+        }
+    }
+    entry.commandLine[length] = '\0';
+
+    m_next = (m_next + 1) % m_entries.size();
+    m_size = std::min(m_size + 1, m_entries.size());
+}
+
+void CommandTrace::dump(Print& output) const {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    const size_t first = (m_next + m_entries.size() - m_size) % std::max<size_t>(m_entries.size(), 1);
+    for (size_t i = 0; i < m_size; i++) {
+        const auto& entry = m_entries[(first + i) % m_entries.size()];
+        output.printf("%" PRIu32 " %" PRIu32 " %u %c %s\n", entry.startMs, entry.durationUs, entry.clientId,
+                      entry.isTruncated ? 'T' : '-', entry.commandLine);
+    }
+}
+}
@@ -33,6 +33,8 @@
 #include <LittleFS.h>
 
 #include "Esp32Cli.h"
+#include "Esp32Cli/Client.h"
+#include "Esp32Cli/FramedStream.h"
 
 #define STATS_TICKS         pdMS_TO_TICKS(1000)
 #define ARRAY_SIZE_OFFSET   5   //Increase this if print_real_time_stats returns ESP_ERR_INVALID_SIZE
@@ -43,6 +45,26 @@ void HostnameCommand::execute(Stream& io, const std::string& commandName, std::v
     io.println(m_cli.getHostname().c_str());
 }
 
+void TagCommand::execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const {
+    if (argv.size() < 3) {
+        Cli::printUsage(io, argv, *this);
+        return;
+    }
+    char* end;
+    const unsigned long tag = std::strtoul(argv[1], &end, 0);
+    if (*end != '\0' || end == argv[1] || tag > UINT16_MAX) {
+        io.printf("Invalid tag %s\n", argv[1]);
+        return;
+    }
+
+    if (client) {
+        client->setCommandTagged();
+    }
+    FramedStream framedIo{io, static_cast<uint16_t>(tag)};
+    m_cli.executeCommand(framedIo, argv.nestedCommand(2), client);
+    framedIo.end();
+}
+
 void MemCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
                          const std::shared_ptr<Client>& client) const {
     multi_heap_info_t info{};
@@ -77,11 +99,93 @@ void ResetCommand::execute(Stream& io, const std::string& commandName, std::vect
 }
 
 #if ESP32_CLI_ENABLE_TELNET
-void IpCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv) {
+void IpCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+                        const std::shared_ptr<Client>& client) const {
     io.println(WiFi.localIP());
 }
 #endif
 
+namespace TraceCommands {
+class OnCommand : public ArgvCommand {
+public:
+    explicit OnCommand(CommandTrace& commandTrace) : m_commandTrace{commandTrace} {}
+
+    using ArgvCommand::execute;
+
+    void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const override {
+        size_t capacity = CommandTrace::DefaultCapacity;
+        if (argv.size() == 2) {
+            char* end;
+            capacity = std::strtoul(argv[1], &end, 0);
+            if (*end != '\0' || capacity == 0 || capacity > CommandTrace::MaximumCapacity) {
+                io.printf("Capacity must be between 1 and %u\n", CommandTrace::MaximumCapacity);
+                return;
+            }
+        } else if (argv.size() != 1) {
+            Cli::printUsage(io, argv, *this);
+            return;
+        }
+        m_commandTrace.enable(capacity);
+    }
+
+    void printUsage(Print& output) const override {
+        output.println("[capacity]");
+    }
+
+private:
+    CommandTrace& m_commandTrace;
+};
+
+class OffCommand : public ArgvCommand {
+public:
+    explicit OffCommand(CommandTrace& commandTrace) : m_commandTrace{commandTrace} {}
+
+    using ArgvCommand::execute;
+
+    void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const override {
+        m_commandTrace.disable();
+    }
+
+private:
+    CommandTrace& m_commandTrace;
+};
+
+class DumpCommand : public ArgvCommand {
+public:
+    explicit DumpCommand(CommandTrace& commandTrace) : m_commandTrace{commandTrace} {}
+
+    using ArgvCommand::execute;
+
+    void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const override {
+        m_commandTrace.dump(io);
+    }
+
+private:
+    CommandTrace& m_commandTrace;
+};
+
+class ClearCommand : public ArgvCommand {
+public:
+    explicit ClearCommand(CommandTrace& commandTrace) : m_commandTrace{commandTrace} {}
+
+    using ArgvCommand::execute;
+
+    void execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const override {
+        m_commandTrace.clear();
+    }
+
+private:
+    CommandTrace& m_commandTrace;
+};
+}
+
+TraceCommand::TraceCommand(CommandTrace& commandTrace) {
+    addCommand<TraceCommands::OnCommand>("on", commandTrace);
+    addCommand<TraceCommands::OffCommand>("off", commandTrace);
+    addCommand<TraceCommands::DumpCommand>("dump", commandTrace);
+    addCommand<TraceCommands::ClearCommand>("clear", commandTrace);
+}
+
 #if ESP32_CLI_ENABLE_FS_COMMANDS
 namespace FsCommands {
 class TouchCommand : public Command {
@@ -0,0 +1,112 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Esp32Cli/DispatchTable.h"
+
+#include "Esp32Cli/CommandContainer.h"
+
+#include <cstring>
+
+namespace Esp32Cli {
+DispatchTable::DispatchTable(const CommandContainer& root) {
+    m_nodes.push_back({"", nullptr, 0, 0, 0, 0, 0});
+    addChildren(RootNode, root);
+    for (auto& node: m_nodes) {
+        buildHashTable(node);
+    }
+    m_nodes.shrink_to_fit();
+    m_slots.shrink_to_fit();
+}
+
+DispatchTable::index_t DispatchTable::find(index_t parent, const char* name) const {
+    const Node& parentNode = m_nodes[parent];
+    if (parentNode.childCount == 0) {
+        return InvalidNode;
+    }
+    uint8_t slot = m_slots[parentNode.firstSlot + (hash(parentNode.seed, name) & parentNode.slotMask)];
+    if (slot == 0) {
+        return InvalidNode;
+    }
+    index_t child = parentNode.firstChild + slot - 1;
+    if (strcmp(m_nodes[child].name, name) != 0) {
+        return InvalidNode;
+    }
+    return child;
+}
+
+uint32_t DispatchTable::hash(uint32_t seed, const char* name) {
+    // FNV-1a with the seed mixed into the offset basis.
+    uint32_t result = 2166136261u ^ seed;
+    for (; *name != '\0'; name++) {
+        result ^= static_cast<uint8_t>(*name);
+        result *= 16777619u;
+    }
+    return result ^ (result >> 15);
+}
+
+void DispatchTable::addChildren(index_t parent, const CommandContainer& container) {
+    const auto& entries = container.getCommandEntries();
+    auto firstChild = static_cast<index_t>(m_nodes.size());
+    m_nodes[parent].firstChild = firstChild;
+    m_nodes[parent].childCount = static_cast<index_t>(entries.size());
+    for (const auto& entry: entries) {
+        m_nodes.push_back({entry.first, entry.second.get(), 0, 0, 0, 0, 0});
+    }
+    for (index_t i = 0; i < entries.size(); i++) {
+        const CommandContainer* subCommands = entries[i].second->getSubCommands();
+        if (subCommands != nullptr) {
+            addChildren(firstChild + i, *subCommands);
+        }
+    }
+}
+
+void DispatchTable::buildHashTable(Node& node) {
+    if (node.childCount == 0) {
+        return;
+    }
+    // A load factor of at most 1/2 finds a collision free seed after a few attempts for the group sizes in use.
+    size_t slotCount = 4;
+    while (slotCount < node.childCount * 2u) {
+        slotCount *= 2;
+    }
+    node.firstSlot = static_cast<index_t>(m_slots.size());
+    m_slots.resize(m_slots.size() + slotCount);
+    uint8_t* slots = m_slots.data() + node.firstSlot;
+
+    for (uint32_t seed = 0;; seed++) {
+        if (seed > 0 && seed % 1000 == 0) {
+            // Unlucky, retry with a sparser table.
+            m_slots.resize(m_slots.size() + slotCount);
+            slotCount *= 2;
+            slots = m_slots.data() + node.firstSlot;
+        }
+        memset(slots, 0, slotCount);
+        bool isPerfect = true;
+        for (index_t i = 0; i < node.childCount && isPerfect; i++) {
+            uint8_t& slot = slots[hash(seed, m_nodes[node.firstChild + i].name) & (slotCount - 1)];
+            isPerfect = slot == 0;
+            slot = static_cast<uint8_t>(i + 1);
+        }
+        if (isPerfect) {
+            node.seed = seed;
+            node.slotMask = static_cast<index_t>(slotCount - 1);
+            return;
+        }
+    }
+}
+}
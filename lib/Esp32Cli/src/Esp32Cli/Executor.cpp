@@ -0,0 +1,122 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Esp32Cli/Executor.h"
+#include "Esp32Cli/Client.h"
+
+#include <algorithm>
+
+namespace Esp32Cli {
+Executor::Executor(const size_t workerCount, const size_t maximumWorkerCount, const uint32_t stackSize)
+    : m_queue{xQueueCreate(QueueLength, sizeof(std::shared_ptr<Client>*))},
+      m_workerCount{workerCount},
+      m_maximumWorkerCount{std::max(workerCount, maximumWorkerCount)},
+      m_stackSize{stackSize} {
+    if (!m_queue) {
+        log_e("Failed to create executor queue");
+        ESP.restart();
+    }
+    m_workers.reserve(m_maximumWorkerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        startWorker();
+    }
+}
+
+Executor::~Executor() {
+    std::unique_lock<std::mutex> lock{m_workersMutex};
+    for (const auto worker : m_workers) {
+        vTaskDelete(worker);
+    }
+    std::shared_ptr<Client>* clientPtr;
+    while (xQueueReceive(m_queue, &clientPtr, 0) == pdTRUE) {
+        delete clientPtr;
+    }
+    vQueueDelete(m_queue);
+}
+
+void Executor::schedule(const std::shared_ptr<Client>& client) {
+    if (!client || client->m_isScheduled.exchange(true)) {
+        return;
+    }
+    auto clientPtr = new std::shared_ptr<Client>(client);
+    if (xQueueSend(m_queue, &clientPtr, 0) != pdTRUE) {
+        log_e("Executor queue full, dropping client");
+        delete clientPtr;
+        client->m_isScheduled = false;
+        return;
+    }
+    if (m_idleWorkers == 0) {
+        startWorker();
+    }
+}
+
+void Executor::startWorker() {
+    std::unique_lock<std::mutex> lock{m_workersMutex};
+    if (m_workers.size() >= m_maximumWorkerCount) {
+        return;
+    }
+    TaskHandle_t worker;
+    if (xTaskCreatePinnedToCore(&startWork, "cli_worker", m_stackSize, this, 0, &worker,
+                                ARDUINO_RUNNING_CORE) != pdPASS) {
+        log_e("Failed to create CLI worker task");
+        if (m_workers.size() < m_workerCount) {
+            ESP.restart();
+        }
+        return;
+    }
+    m_workers.push_back(worker);
+}
+
+bool Executor::removeIdleWorker() {
+    std::unique_lock<std::mutex> lock{m_workersMutex};
+    if (m_workers.size() <= m_workerCount) {
+        return false;
+    }
+    const auto worker = std::find(m_workers.begin(), m_workers.end(), xTaskGetCurrentTaskHandle());
+    if (worker != m_workers.end()) {
+        m_workers.erase(worker);
+    }
+    return true;
+}
+
+void Executor::work() {
+    do {
+        std::shared_ptr<Client>* clientPtr;
+        m_idleWorkers++;
+        const bool received = xQueueReceive(m_queue, &clientPtr, pdMS_TO_TICKS(IdleWorkerTimeoutMs)) == pdTRUE;
+        m_idleWorkers--;
+        if (!received) {
+            if (removeIdleWorker()) {
+                vTaskDelete(nullptr);
+            }
+            continue;
+        }
+        auto client = std::move(*clientPtr);
+        delete clientPtr;
+
+        client->m_executingWorkers++;
+        do {
+            client->executeCommandLine(Client::ExecType::NonBlocking);
+            client->m_isScheduled = false;
+            // Input arriving between the last read and clearing the flag did not queue the client again.
+        } while (client->hasPendingInput() && !client->m_isScheduled.exchange(true));
+        client->m_executingWorkers--;
+    } while (true);
+}
+}
@@ -0,0 +1,62 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Esp32Cli/FramedStream.h"
+
+namespace Esp32Cli {
+size_t FramedStream::write(const uint8_t* buffer, const size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        if (m_payloadSize == MaximumPayloadSize) {
+            writeFrame();
+        }
+        const size_t chunkSize = std::min(size - written, MaximumPayloadSize - m_payloadSize);
+        memcpy(m_payload.data() + m_payloadSize, buffer + written, chunkSize);
+        m_payloadSize += chunkSize;
+        written += chunkSize;
+    }
+    return written;
+}
+
+void FramedStream::flush() {
+    if (m_payloadSize > 0) {
+        writeFrame();
+    }
+    m_stream.flush();
+}
+
+void FramedStream::end() {
+    if (m_payloadSize > 0) {
+        writeFrame();
+    }
+    writeFrame();
+}
+
+void FramedStream::writeFrame() {
+    const uint8_t header[HeaderSize]{
+        FrameStart,
+        static_cast<uint8_t>(m_tag),
+        static_cast<uint8_t>(m_tag >> 8),
+        static_cast<uint8_t>(m_payloadSize),
+    };
+    m_stream.write(header, HeaderSize);
+    m_stream.write(m_payload.data(), m_payloadSize);
+    m_payloadSize = 0;
+}
+}
@@ -18,6 +18,8 @@
 
 #include "Esp32Cli/ScriptCommand.h"
 
+#include <sys/stat.h>
+
 #if ESP32_CLI_ENABLE_FS_COMMANDS
 
 namespace Esp32Cli {
@@ -26,8 +28,36 @@ void ScriptCommand::execute(Stream& io, const std::string& commandName, std::vec
         Cli::printUsage(io, commandName, *this);
         return;
     }
-    auto scriptClient = std::make_shared<ScriptClient>(m_cli, argv[1].c_str(), &io);
+    const char* fileName = argv[1].c_str();
+    struct stat fileStat{};
+    if (stat(fileName, &fileStat) != 0) {
+        io.printf("File %s not found\n", fileName);
+        return;
+    }
+
+    auto scriptClient = std::make_shared<ScriptClient>(m_cli, &io);
+    const auto parsedScript = findParsedScript(fileName, fileStat.st_mtime, fileStat.st_size);
+    if (parsedScript) {
+        scriptClient->executeParsedScript(*parsedScript);
+        return;
+    }
+
+    if (!scriptClient->open(fileName)) {
+        io.printf("File %s not found\n", fileName);
+        return;
+    }
+    if (fileStat.st_size <= static_cast<off_t>(MaximumCachedScriptSize)) {
+        std::shared_ptr<ParsedScript> recording{new ParsedScript{}};
+        recording->fileName = fileName;
+        recording->modificationTime = fileStat.st_mtime;
+        recording->size = fileStat.st_size;
+        scriptClient->startRecording(std::move(recording));
+    }
     scriptClient->executeCommandLine(Client::ExecType::Blocking);
+    auto recordedScript = scriptClient->finishRecording();
+    if (recordedScript) {
+        addParsedScript(std::move(recordedScript));
+    }
 }
 
 void ScriptCommand::printUsage(Print& output) const {
@@ -38,26 +68,90 @@ void ScriptCommand::printHelp(Print& output, const std::string& commandName, std
     output.println("Run commands from a file");
 }
 
-ScriptCommand::ScriptClient::ScriptClient(std::shared_ptr<Cli> cli, const char* fileName, Stream* output)
+std::shared_ptr<const ScriptCommand::ParsedScript> ScriptCommand::findParsedScript(
+        const char* fileName, const time_t modificationTime, const off_t size) const {
+    std::unique_lock<std::mutex> lock{m_cacheMutex};
+    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+        const auto& parsedScript = *it;
+        if (parsedScript->fileName != fileName) {
+            continue;
+        }
+        if (parsedScript->modificationTime != modificationTime || parsedScript->size != size) {
+            m_cache.erase(it);
+            return nullptr;
+        }
+        m_cache.splice(m_cache.begin(), m_cache, it);
+        return m_cache.front();
+    }
+    return nullptr;
+}
+
+void ScriptCommand::addParsedScript(std::shared_ptr<const ParsedScript> parsedScript) const {
+    std::unique_lock<std::mutex> lock{m_cacheMutex};
+    // A concurrent run of the same script might have added it already.
+    m_cache.remove_if([&parsedScript](const std::shared_ptr<const ParsedScript>& cachedScript) {
+        return cachedScript->fileName == parsedScript->fileName;
+    });
+    m_cache.push_front(std::move(parsedScript));
+    if (m_cache.size() > MaximumCachedScripts) {
+        m_cache.pop_back();
+    }
+}
+
+ScriptCommand::ScriptClient::ScriptClient(std::shared_ptr<Cli> cli, Stream* output)
         : Client{std::move(cli)},
           m_output{output} {
+}
+
+ScriptCommand::ScriptClient::~ScriptClient() {
+    m_output = nullptr;
+    if (m_input) {
+        fclose(m_input);
+    }
+}
+
+bool ScriptCommand::ScriptClient::open(const char* fileName) {
     m_input = fopen(fileName, "r");
     if (!m_input) {
-        output->printf("File %s not found\n", fileName);
-        return;
+        return false;
     }
 
     fseek(m_input, 0, SEEK_END);
     m_bytesLeft = ftell(m_input);
     fseek(m_input, 0, SEEK_SET);
+    return true;
 }
 
-ScriptCommand::ScriptClient::~ScriptClient() {
-    m_output = nullptr;
-    fclose(m_input);
+void ScriptCommand::ScriptClient::startRecording(std::shared_ptr<ParsedScript> parsedScript) {
+    m_parsedScript = std::move(parsedScript);
+}
+
+std::shared_ptr<ScriptCommand::ParsedScript> ScriptCommand::ScriptClient::finishRecording() {
+    if (m_parsedScript) {
+        m_parsedScript->argBuffer.shrink_to_fit();
+        m_parsedScript->argOffsets.shrink_to_fit();
+        m_parsedScript->commands.shrink_to_fit();
+    }
+    return std::move(m_parsedScript);
+}
+
+void ScriptCommand::ScriptClient::executeParsedScript(const ParsedScript& parsedScript) {
+    std::array<const char*, MaximumArgc + 1> argv{};
+    const auto self = shared_from_this();
+    for (const auto& command: parsedScript.commands) {
+        for (size_t i = 0; i < command.second; i++) {
+            argv[i] = parsedScript.argBuffer.data() + parsedScript.argOffsets[command.first + i];
+        }
+        argv[command.second] = nullptr;
+        m_cli->executeCommand(*this, ArgvView{argv.data(), command.second}, self);
+        onCommandEnd();
+    }
 }
 
 size_t ScriptCommand::ScriptClient::write(const uint8_t* buffer, size_t size) {
+    if (!m_output) {
+        return 0;
+    }
     return m_output->write(buffer, size);
 }
 
@@ -70,29 +164,88 @@ size_t ScriptCommand::ScriptClient::write(uint8_t c) {
 }
 
 int ScriptCommand::ScriptClient::available() {
-    if (!m_input) {
-        return 0;
-    }
     return static_cast<int>(m_bytesLeft);
 }
 
 size_t ScriptCommand::ScriptClient::readBytes(char* buffer, size_t length) {
-    const size_t readSize = min(length, m_bytesLeft);
-    fread(buffer, readSize, 1, m_input);
-    m_bytesLeft -= readSize;
-    return readSize;
+    size_t bytesRead = 0;
+    while (bytesRead < length) {
+        const size_t buffered = fillBuffer();
+        if (buffered == 0) {
+            break;
+        }
+        const size_t readSize = std::min(length - bytesRead, buffered);
+        memcpy(buffer + bytesRead, m_buffer.data() + m_bufferPosition, readSize);
+        consumeInput(readSize);
+        bytesRead += readSize;
+    }
+    return bytesRead;
 }
 
 int ScriptCommand::ScriptClient::read() {
-    const int result = fgetc(m_input);
-    if (result > 0) {
-        m_bytesLeft--;
+    if (fillBuffer() == 0) {
+        return -1;
     }
+    const int result = static_cast<uint8_t>(m_buffer[m_bufferPosition]);
+    consumeInput(1);
     return result;
 }
 
 int ScriptCommand::ScriptClient::peek() {
-    return -1; // TODO: Implement peek for file io.
+    if (fillBuffer() == 0) {
+        return -1;
+    }
+    return static_cast<uint8_t>(m_buffer[m_bufferPosition]);
+}
+
+size_t ScriptCommand::ScriptClient::borrowInput(const char** data, ExecType execType) {
+    const size_t buffered = fillBuffer();
+    *data = m_buffer.data() + m_bufferPosition;
+    return buffered;
+}
+
+void ScriptCommand::ScriptClient::consumeInput(const size_t size) {
+    m_bufferPosition += size;
+    m_bytesLeft -= size;
+    m_bytesConsumed += size;
+}
+
+void ScriptCommand::ScriptClient::executeCommand(const ArgvView& argv) {
+    m_gotCommand = true;
+    if (m_parsedScript) {
+        m_parsedScript->commands.emplace_back(m_parsedScript->argOffsets.size(), argv.size());
+        for (size_t i = 0; i < argv.size(); i++) {
+            m_parsedScript->argOffsets.push_back(m_parsedScript->argBuffer.size());
+            const char* arg = argv[i];
+            m_parsedScript->argBuffer.insert(m_parsedScript->argBuffer.end(), arg, arg + strlen(arg) + 1);
+        }
+    }
+
+    const size_t bytesConsumed = m_bytesConsumed;
+    Client::executeCommand(argv);
+    if (m_bytesConsumed != bytesConsumed) {
+        // The command read data from the script, replaying only the commands would lose the data.
+        m_parsedScript.reset();
+    }
+}
+
+void ScriptCommand::ScriptClient::onCommandEnd() {
+    if (!m_gotCommand) {
+        // Binary frames and invalid command lines are not recorded.
+        m_parsedScript.reset();
+    }
+    m_gotCommand = false;
+}
+
+size_t ScriptCommand::ScriptClient::fillBuffer() {
+    if (m_bufferPosition == m_bufferSize && m_input && m_bytesLeft > 0) {
+        m_bufferSize = fread(m_buffer.data(), 1, std::min(m_buffer.size(), m_bytesLeft), m_input);
+        m_bufferPosition = 0;
+        if (m_bufferSize == 0) {
+            m_bytesLeft = 0;
+        }
+    }
+    return m_bufferSize - m_bufferPosition;
 }
 }
 
@@ -30,8 +30,8 @@ void TelnetAwareClient::executeCommandLine(const ExecType execType) {
         if (execType == ExecType::NonBlocking && !m_arduinoClient->available()) {
             return;
         }
-        while (m_arduinoClient->readBytes(&c, 1) != 1) {
-            if (execType == ExecType::NonBlocking) {
+        while (readInput(&c, 1) != 1) {
+            if (execType == ExecType::NonBlocking || !isConnected()) {
                 return;
             }
         }
@@ -41,10 +41,16 @@ void TelnetAwareClient::executeCommandLine(const ExecType execType) {
             continue;
         }
 
+        if (c == BinaryFrameStart && m_lineBuffer.empty() && m_historyIterator == m_history.end()) {
+            executeBinaryFrame();
+            continue;
+        }
+
         if (c == '\n' || c == '\r') {
             if (m_gotTelnetCommand) {
                 // Read the additional null byte sent by the telnet client.
-                m_arduinoClient->read();
+                char nullByte;
+                readInput(&nullByte, 1);
             }
 
             if (!m_lineBuffer.empty() || m_historyIterator != m_history.end() || c == '\n') {
@@ -65,6 +71,7 @@ void TelnetAwareClient::executeCommandLine(const ExecType execType) {
                 Client::executeCommandLine(ExecType::Blocking);
                 overwriteLineBuffer("");
                 m_cli->printPrompt(*this);
+                flush();
             }
         } else if (c == 3) {
             // CTRL+c
@@ -74,11 +81,11 @@ void TelnetAwareClient::executeCommandLine(const ExecType execType) {
             m_historyIterator = m_history.end();
         } else if (c == 27) {
             // ESC
-            m_arduinoClient->readBytes(&c, 1);
+            readInput(&c, 1);
             if (c != '[') {
                 continue;
             }
-            m_arduinoClient->readBytes(&c, 1);
+            readInput(&c, 1);
             switch (c) {
                 case 'A': // Up
                     if (m_historyIterator != m_history.begin()) {
@@ -159,11 +166,124 @@ void TelnetAwareClient::executeCommandLine(const ExecType execType) {
     } while (true);
 }
 
+void TelnetAwareClient::executeBinaryFrame() {
+    // Binary frames bypass the line editor, their bytes would otherwise be filtered or taken as line breaks. The
+    // frame is handed to the command parser unchanged.
+    m_lineBuffer.assign(1, BinaryFrameStart);
+    uint8_t header[2];
+    for (auto& value: header) {
+        if (!readFrameByte(value)) {
+            overwriteLineBuffer("");
+            return;
+        }
+        m_lineBuffer.push_back(static_cast<char>(value));
+    }
+    for (uint8_t i = 0; i < header[1]; i++) {
+        uint8_t value;
+        if (!readFrameByte(value)) {
+            overwriteLineBuffer("");
+            return;
+        }
+        m_lineBuffer.push_back(static_cast<char>(value));
+    }
+    m_lineBufferReadPosition = 0;
+    Client::executeCommandLine(ExecType::Blocking);
+    overwriteLineBuffer("");
+    flush();
+}
+
+bool TelnetAwareClient::readFrameByte(uint8_t& value) {
+    // Telnet clients escape a 0xff data byte as IAC IAC, raw TCP clients send it as is.
+    const bool unescape = m_gotTelnetCommand;
+    bool escaped = false;
+    do {
+        while (readInput(&value, 1) != 1) {
+            if (!isConnected()) {
+                return false;
+            }
+        }
+        escaped = unescape && !escaped && value == static_cast<uint8_t>(Telnet::IAC);
+    } while (escaped);
+    return true;
+}
+
+size_t TelnetAwareClient::readInput(uint8_t* buffer, const size_t size) {
+    const size_t bytesRead = m_arduinoClient->readBytes(buffer, size);
+    m_bytesReceived += bytesRead;
+    return bytesRead;
+}
+
+bool TelnetAwareClient::hasPendingInput() {
+    return m_arduinoClient->available() > 0;
+}
+
+void TelnetAwareClient::disconnect() {
+    m_arduinoClient->stop();
+    onDisconnect();
+}
+
 size_t TelnetAwareClient::write(uint8_t value) {
-    if (value == '\n') {
-        m_arduinoClient->write('\r');
+    return write(&value, 1);
+}
+
+size_t TelnetAwareClient::write(const uint8_t* buffer, const size_t size) {
+    std::unique_lock<std::mutex> lock{m_outputMutex};
+    if (m_outputSize == 0) {
+        m_outputStartMs = millis();
+    }
+    size_t written = 0;
+    while (written < size) {
+        // Keep space for at least one byte and the line break translated to \r\n.
+        if (m_outputBuffer.size() - m_outputSize < 3) {
+            flushOutput();
+        }
+        const auto lineEnd = static_cast<const uint8_t*>(memchr(buffer + written, '\n', size - written));
+        const size_t lineLength = (lineEnd != nullptr ? lineEnd - buffer : size) - written;
+        const size_t copySize = std::min(lineLength, m_outputBuffer.size() - m_outputSize - 2);
+        memcpy(m_outputBuffer.data() + m_outputSize, buffer + written, copySize);
+        m_outputSize += copySize;
+        written += copySize;
+        if (copySize == lineLength && lineEnd != nullptr) {
+            m_outputBuffer[m_outputSize++] = '\r';
+            m_outputBuffer[m_outputSize++] = '\n';
+            written++;
+        }
+    }
+    if (m_outputSize == m_outputBuffer.size()) {
+        flushOutput();
+    }
+    return written;
+}
+
+void TelnetAwareClient::flush() {
+    std::unique_lock<std::mutex> lock{m_outputMutex};
+    flushOutput();
+}
+
+void TelnetAwareClient::flushStaleOutput() {
+    std::unique_lock<std::mutex> lock{m_outputMutex};
+    if (m_outputSize > 0 && millis() - m_outputStartMs >= OutputFlushDelayMs) {
+        flushOutput();
+    }
+}
+
+void TelnetAwareClient::onCommandEnd() {
+    flush();
+}
+
+void TelnetAwareClient::flushOutput() {
+    size_t written = 0;
+    while (written < m_outputSize) {
+        const size_t writeSize = m_arduinoClient->write(m_outputBuffer.data() + written, m_outputSize - written);
+        if (writeSize == 0) {
+            // Connection closed, drop the output.
+            break;
+        }
+        written += writeSize;
     }
-    return m_arduinoClient->write(value);
+    m_bytesSent += written;
+    m_outputSize = 0;
+    m_outputStartMs = millis();
 }
 
 int TelnetAwareClient::available() {
@@ -203,11 +323,11 @@ void TelnetAwareClient::handleTelnetCommand() {
         m_cli->printWelcome(*m_arduinoClient);
     }
 
-    m_arduinoClient->readBytes(&c, 1);
+    readInput(&c, 1);
 
     TelnetOption opt;
     if (cmd == Telnet::WILL || cmd == Telnet::DO || cmd == Telnet::WONT || cmd == Telnet::DONT || cmd == Telnet::SB) {
-        m_arduinoClient->readBytes(reinterpret_cast<uint8_t*>(&opt), 1);
+        readInput(reinterpret_cast<uint8_t*>(&opt), 1);
     }
 
     switch (cmd) {
@@ -253,8 +373,8 @@ void TelnetAwareClient::handleTelnetCommand() {
             break;
         */
         case Telnet::SB:
-            m_arduinoClient->readBytes(&c, 1);
-            for (int i = 0; cmd != Telnet::IAC; i++, m_arduinoClient->readBytes(&c, 1)) {
+            readInput(&c, 1);
+            for (int i = 0; cmd != Telnet::IAC; i++, readInput(&c, 1)) {
                 if (i >= 16) {
                     continue;
                 }
@@ -269,7 +389,7 @@ void TelnetAwareClient::handleTelnetCommand() {
                 m_arduinoClient->printf(",%s", &buf[1]);
             }
             */
-            m_arduinoClient->readBytes(&c, 1); // Should be SE.
+            readInput(&c, 1); // Should be SE.
         default: // Unhandled
             break;
     }
@@ -16,54 +16,160 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+
 #if ESP32_CLI_ENABLE_TELNET
 
 #include "Esp32Cli/TelnetServer.h"
 #include "Esp32Cli/TelnetAwareClient.h"
 
+#include <fcntl.h>
+#include <cinttypes>
+#include <limits>
+#include <lwip/sockets.h>
+
 namespace Esp32Cli {
 TelnetServer::TelnetServer(std::shared_ptr<Cli> cli, const uint16_t port)
     : m_cli{std::move(cli)} {
-    m_wiFiServer.begin(port, 1);
-    m_wiFiServer.setNoDelay(true);
-    if (xTaskCreate(&startListen, "telnet_server", 1024, this, 1, &m_listenTask) != pdPASS) {
+    m_listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenFd < 0) {
+        log_e("Failed to create telnet socket");
+        return;
+    }
+    int enable = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(m_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(m_listenFd, MaximumClients) != 0) {
+        log_e("Failed to listen on telnet port %u", port);
+        close(m_listenFd);
+        m_listenFd = -1;
+        return;
+    }
+    fcntl(m_listenFd, F_SETFL, fcntl(m_listenFd, F_GETFL, 0) | O_NONBLOCK);
+
+    if (xTaskCreate(&startListen, "telnet_server", 2048, this, 1, &m_listenTask) != pdPASS) {
         log_e("Failed to create telnet listen task");
         ESP.restart();
     }
 }
 
 TelnetServer::~TelnetServer() {
-    m_wiFiServer.end();
-    vTaskDelete(m_listenTask);
+    if (m_listenTask) {
+        vTaskDelete(m_listenTask);
+    }
+    for (auto& session: m_sessions) {
+        session.client->disconnect();
+    }
+    if (m_listenFd >= 0) {
+        close(m_listenFd);
+    }
+}
+
+TelnetServer::Stats TelnetServer::getStats() const {
+    std::unique_lock<std::mutex> lock{m_sessionsMutex};
+    Stats stats{
+        m_acceptedConnections,
+        m_rejectedConnections,
+        static_cast<uint32_t>(m_sessions.size()),
+        m_closedBytesReceived,
+        m_closedBytesSent,
+    };
+    for (const auto& session: m_sessions) {
+        stats.bytesReceived += session.client->getBytesReceived();
+        stats.bytesSent += session.client->getBytesSent();
+    }
+    return stats;
 }
 
 void TelnetServer::listen() {
     do {
-        WiFiClient wiFiClient = m_wiFiServer.accept();
-        if (wiFiClient) {
-            std::unique_ptr<WiFiClient> wiFiClientPtr(new WiFiClient(wiFiClient));
-            auto client = std::make_shared<TelnetAwareClient>(m_cli, std::move(wiFiClientPtr));
-            auto clientPtr = new std::shared_ptr<TelnetAwareClient>(client);
-            if (xTaskCreate(&handleClient, "telnet_client", 4096, clientPtr, 1, nullptr) != pdPASS) {
-                log_e("Failed to create telnet client task");
-                delete clientPtr;
+        removeClosedSessions();
+
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(m_listenFd, &readSet);
+        int maxFd = m_listenFd;
+        for (const auto& session: m_sessions) {
+            // Busy clients are checked for more input by the executor, waiting for their sockets would only spin.
+            if (!session.client->isScheduled() && !session.client->isExecuting()) {
+                FD_SET(session.fd, &readSet);
+                maxFd = std::max(maxFd, session.fd);
             }
-        } else {
-            delay(20);
         }
-    } while(true);
+        timeval timeout{0, PollIntervalMs * 1000};
+        const int readyCount = select(maxFd + 1, &readSet, nullptr, nullptr, &timeout);
+        if (readyCount < 0) {
+            log_e("Telnet select failed: %i", errno);
+            delay(PollIntervalMs);
+            continue;
+        }
+
+        for (const auto& session: m_sessions) {
+            // A socket closed by the peer is readable too, the client finds nothing to read and is removed next round.
+            if (readyCount > 0 && FD_ISSET(session.fd, &readSet)) {
+                m_cli->schedule(session.client);
+            }
+            session.client->flushStaleOutput();
+        }
+
+        if (readyCount > 0 && FD_ISSET(m_listenFd, &readSet)) {
+            acceptClient();
+        }
+    } while (true);
 }
 
-void TelnetServer::handleClient(void* arg) {
-    const auto clientPtr = static_cast<std::shared_ptr<Client>*>(arg);
-    auto client = *clientPtr;
-    delete clientPtr;
+void TelnetServer::removeClosedSessions() {
+    auto sessionIterator = m_sessions.begin();
+    while (sessionIterator != m_sessions.end()) {
+        const auto& client = sessionIterator->client;
+        // Closed by the peer or by the session itself (end of transmission). Its socket must not be passed to
+        // select() anymore, but tear down only once the executor released the client.
+        if (client->isScheduled() || client->isExecuting() || client->isConnected()) {
+            ++sessionIterator;
+            continue;
+        }
+        client->disconnect();
+        std::unique_lock<std::mutex> lock{m_sessionsMutex};
+        m_closedBytesReceived += client->getBytesReceived();
+        m_closedBytesSent += client->getBytesSent();
+        sessionIterator = m_sessions.erase(sessionIterator);
+    }
+}
 
+void TelnetServer::acceptClient() {
+    sockaddr_in address{};
+    socklen_t addressLength = sizeof(address);
+    const int fd = accept(m_listenFd, reinterpret_cast<sockaddr*>(&address), &addressLength);
+    if (fd < 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock{m_sessionsMutex};
+    if (m_sessions.size() >= MaximumClients) {
+        m_rejectedConnections++;
+        static const char message[] = "Too many connections\r\n";
+        send(fd, message, sizeof(message) - 1, 0);
+        close(fd);
+        return;
+    }
+    m_acceptedConnections++;
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    std::unique_ptr<WiFiClient> wiFiClient(new WiFiClient(fd));
+    auto client = std::make_shared<TelnetAwareClient>(m_cli, std::move(wiFiClient));
     client->setTimeout(std::numeric_limits<unsigned long>::max());
-    client->executeCommandLine(Client::ExecType::Blocking);
+    m_sessions.push_back({fd, std::move(client)});
+}
 
-    client.reset();
-    vTaskDelete(nullptr);
+void TelnetCommand::execute(Stream& io, const ArgvView& argv, const std::shared_ptr<Client>& client) const {
+    const auto stats = m_telnetServer->getStats();
+    io.printf("active_connections = %" PRIu32 "\n", stats.activeConnections);
+    io.printf("accepted_connections = %" PRIu32 "\n", stats.acceptedConnections);
+    io.printf("rejected_connections = %" PRIu32 "\n", stats.rejectedConnections);
+    io.printf("bytes_received = %" PRIu32 "\n", stats.bytesReceived);
+    io.printf("bytes_sent = %" PRIu32 "\n", stats.bytesSent);
 }
 }
 
@@ -0,0 +1,52 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <Esp32Cli.h>
+#include <Esp32Cli/Command.h>
+
+namespace Esp32DeltaOtaCommands {
+/**
+ * Execute a command with its output compressed by heatshrink (window 11 bits, lookahead 9 bits, same as firmware dump).
+ *
+ * The compressed data is sent in blocks [size: uint16 LE][data], followed by an empty block and a trailer of
+ * [uncompressed size: uint32 LE][CRC-32 of the uncompressed data: uint32 LE].
+ */
+class CompressCommand : public Esp32Cli::ArgvCommand {
+public:
+    explicit CompressCommand(Esp32Cli::Cli& cli) : m_cli{cli} {}
+
+    using Esp32Cli::ArgvCommand::execute;
+
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override;
+
+    void printUsage(Print& output) const override {
+        output.println("<command> [args...]");
+    }
+
+    void printHelp(Print& output, const std::string& commandName, std::vector<std::string>& argv) const override {
+        Esp32Cli::Cli::printUsage(output, commandName, *this);
+        output.println("Run a command with heatshrink compressed output.");
+    }
+
+private:
+    Esp32Cli::Cli& m_cli;
+};
+}
@@ -0,0 +1,166 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "CompressCommand.h"
+
+#include <array>
+#include <esp_rom_crc.h>
+
+extern "C" {
+#include "heatshrink/heatshrink_encoder.h"
+}
+
+namespace Esp32DeltaOtaCommands {
+namespace {
+/**
+ * Stream compressing everything written to it in the format described at @link CompressCommand. Reads are forwarded
+ * to the wrapped stream unchanged.
+ */
+class CompressingStream : public Stream {
+public:
+    static constexpr size_t BlockSize = 256;
+
+    explicit CompressingStream(Stream& stream)
+        : m_stream{stream}, m_encoder{heatshrink_encoder_alloc(11, 9)} {
+    }
+
+    ~CompressingStream() override {
+        if (m_encoder) {
+            heatshrink_encoder_free(m_encoder);
+        }
+    }
+
+    bool isValid() const {
+        return m_encoder != nullptr;
+    }
+
+    size_t write(uint8_t value) override {
+        return write(&value, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        size_t consumed = 0;
+        while (consumed < size) {
+            size_t sunk = 0;
+            if (heatshrink_encoder_sink(m_encoder, const_cast<uint8_t*>(buffer) + consumed, size - consumed,
+                                        &sunk) != HSER_SINK_OK) {
+                log_e("Heatshrink error in sink");
+                break;
+            }
+            consumed += sunk;
+            poll();
+        }
+        m_crc = esp_rom_crc32_le(m_crc, buffer, consumed);
+        m_rawSize += consumed;
+        return consumed;
+    }
+
+    /**
+     * Compress the remaining data and write the end block and trailer.
+     */
+    void finish() {
+        HSE_finish_res result;
+        while ((result = heatshrink_encoder_finish(m_encoder)) == HSER_FINISH_MORE) {
+            poll();
+        }
+        if (result != HSER_FINISH_DONE) {
+            log_e("Heatshrink error %i in finish", result);
+        }
+        if (m_blockSize > 0) {
+            writeBlock();
+        }
+        writeBlock();
+        const uint8_t trailer[8]{
+            static_cast<uint8_t>(m_rawSize), static_cast<uint8_t>(m_rawSize >> 8),
+            static_cast<uint8_t>(m_rawSize >> 16), static_cast<uint8_t>(m_rawSize >> 24),
+            static_cast<uint8_t>(m_crc), static_cast<uint8_t>(m_crc >> 8),
+            static_cast<uint8_t>(m_crc >> 16), static_cast<uint8_t>(m_crc >> 24),
+        };
+        m_stream.write(trailer, sizeof(trailer));
+    }
+
+    int available() override {
+        return m_stream.available();
+    }
+
+    int read() override {
+        return m_stream.read();
+    }
+
+    int peek() override {
+        return m_stream.peek();
+    }
+
+    using Stream::readBytes;
+
+    size_t readBytes(char* buffer, size_t length) override {
+        return m_stream.readBytes(buffer, length);
+    }
+
+private:
+    void poll() {
+        HSE_poll_res result;
+        do {
+            size_t polled = 0;
+            result = heatshrink_encoder_poll(m_encoder, m_block.data() + m_blockSize, BlockSize - m_blockSize, &polled);
+            if (result < 0) {
+                log_e("Heatshrink error %i in poll", result);
+                return;
+            }
+            m_blockSize += polled;
+            if (m_blockSize == BlockSize) {
+                writeBlock();
+            }
+        } while (result == HSER_POLL_MORE);
+    }
+
+    /**
+     * Write the buffered compressed data as a block. Writes the end block if no data is buffered.
+     */
+    void writeBlock() {
+        const uint8_t header[2]{static_cast<uint8_t>(m_blockSize), static_cast<uint8_t>(m_blockSize >> 8)};
+        m_stream.write(header, sizeof(header));
+        m_stream.write(m_block.data(), m_blockSize);
+        m_blockSize = 0;
+    }
+
+    Stream& m_stream;
+    heatshrink_encoder* m_encoder;
+    std::array<uint8_t, BlockSize> m_block{};
+    size_t m_blockSize{0};
+    uint32_t m_rawSize{0};
+    uint32_t m_crc{0};
+};
+}
+
+void CompressCommand::execute(Stream& io, const Esp32Cli::ArgvView& argv,
+                              const std::shared_ptr<Esp32Cli::Client>& client) const {
+    if (argv.size() < 2) {
+        Esp32Cli::Cli::printUsage(io, argv, *this);
+        return;
+    }
+    CompressingStream compressingIo{io};
+    if (!compressingIo.isValid()) {
+        io.println("Out of memory");
+        return;
+    }
+    m_cli.executeCommand(compressingIo, argv.nestedCommand(1), client);
+    compressingIo.finish();
+}
+}
@@ -18,6 +18,7 @@
 
 #include "Esp32DeltaOta.h"
 
+#include "CompressCommand.h"
 #include "FirmwareCommand.h"
 
 #include <esp_core_dump.h>
@@ -56,6 +57,7 @@ Esp32DeltaOta::Esp32DeltaOta(std::shared_ptr<Esp32Cli::Cli> cli, std::shared_ptr
         "firmware", *this, m_startedProgramState == ProgramState::RecoveryTest
     );
     m_cli->addCommand<CoreDumpCommand>("core-dump");
+    m_cli->addCommand<Esp32DeltaOtaCommands::CompressCommand>("z", *m_cli);
 
     if (m_startedProgramState == ProgramState::New || m_startedProgramState == ProgramState::RecoveryTest) {
         // Newly flashed program, updater should now test recovery boot by requesting recovery mode. Or:
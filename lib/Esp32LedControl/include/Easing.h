@@ -193,7 +193,7 @@ public:
                (1 + bounceOut(2 * x - 1)) / 2;
     }
 
-    static ease_func_t getFuncByName(const std::string& name);
+    static ease_func_t getFuncByName(const char* name);
 
     static inline float apply(float value) {
         return easeInOutExpo(value);
@@ -27,8 +27,6 @@
 #include <random>
 #include <NeoPixelBus.h>
 
-#include "HslwColor.h"
-
 class LedView;
 
 namespace Led {
@@ -126,10 +124,10 @@ struct Animation {
      *
      * For @link blending = @link Blending::Add:
      * Peak color value added to the LEDs color.
+     *
+     * Converted from the configured @link HslwColor once when the animation is added, brightness already applied.
      */
-    HslwColor targetColor;
-
-    float targetBrightness;
+    RgbwColor targetColor;
 
     /**
      * Time the animation starts at.
@@ -156,6 +154,13 @@ struct Animation {
 
     std::vector<std::weak_ptr<LedView> > affectedLedViews;
 
-    static RndDuration parseDuration(std::string durationStr);
+    static RndDuration parseDuration(const std::string& durationStr);
+
+    static RndDuration parseDuration(const char* durationStr);
+
+    /**
+     * Parse a duration from [begin, end) without allocating.
+     */
+    static RndDuration parseDuration(const char* begin, const char* end);
 };
 }
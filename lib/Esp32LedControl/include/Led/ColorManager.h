@@ -2,17 +2,124 @@
 
 #include "HslwColor.h"
 
+#include <array>
 #include <LightweightMap.h>
+#include <mutex>
 #include <NeoPixelBus.h>
 #include <string>
 
 namespace Led {
 class ColorManager {
 public:
+    using handle_t = uint16_t;
+
+    static constexpr handle_t InvalidHandle = 0xffff;
+
+    /**
+     * Maximum number of distinct color strings kept parsed. Color strings without a handle are evicted when a new one
+     * needs the space, the least recently used first.
+     */
+    static constexpr size_t CacheSize = 64;
+
+    /**
+     * Maximum number of handles. Handles stay valid for the lifetime of the color manager, even when the named colors
+     * are reloaded, so they are never evicted from the cache.
+     */
+    static constexpr size_t MaximumHandles = 32;
+
+    ColorManager() {
+        m_buckets.fill(EmptyBucket);
+    }
+
     void loadColorsFromConfig(const std::string& namedColorPath);
 
+    /**
+     * Parses the color string once and returns a handle that can be passed to @link resolve or, as "@<handle>", to any
+     * command taking a color. Returns @link InvalidHandle if all handles are handed out.
+     */
+    handle_t intern(const std::string& colorString) const;
+
+    HslwColor resolve(handle_t handle, const HslwColor& primaryColor = {{0, 0, 0}, 0, 0}) const;
+
     HslwColor parseColor(const std::string& colorString, const HslwColor& primaryColor = {{0, 0, 0}, 0, 0}) const;
+
 private:
+    /**
+     * Pre-parsed color. Named colors are resolved at parse time, only the primary color is looked up on use.
+     */
+    struct ColorSpec {
+        bool primary{false};
+        HslwColor color{0.f};
+        float intensity{1.f};
+    };
+
+    struct Entry {
+        std::string colorString;
+        uint32_t hash{0};
+        ColorSpec spec;
+        bool isUsed{false};
+        /**
+         * Handed out by @link intern, the index of the entry is its handle.
+         */
+        bool isPinned{false};
+        /**
+         * Set on each use, cleared when the eviction clock hand passes the entry.
+         */
+        bool isReferenced{false};
+    };
+
+    static constexpr uint8_t EmptyBucket = 0xff;
+    static constexpr size_t BucketCount = CacheSize * 2;
+
+    static uint32_t hash(const std::string& colorString);
+
+    static HslwColor resolve(const ColorSpec& spec, const HslwColor& primaryColor) {
+        if (spec.primary) {
+            return {primaryColor.hslColor(), primaryColor.w(), spec.intensity};
+        }
+        return spec.color;
+    }
+
+    ColorSpec parseSpec(const std::string& colorString) const;
+
+    bool isHandle(handle_t handle) const {
+        return handle < CacheSize && m_entries[handle].isPinned;
+    }
+
+    /**
+     * Look up the color string in the cache and parse and insert it if missing.
+     * @param pin Hand out the entry as handle.
+     * @return Index of the entry, @link InvalidHandle if it should be pinned but all handles are handed out.
+     */
+    handle_t findOrInsert(const std::string& colorString, ColorSpec* spec, bool pin) const;
+
+    /**
+     * Pick the entry for a new color string. Takes a free entry or evicts the next entry without handle the clock
+     * hand finds not used since it last passed. Requires m_cacheMutex.
+     */
+    size_t evictEntry() const;
+
+    /**
+     * @return First free bucket in the probe sequence of the hash. Requires m_cacheMutex.
+     */
+    size_t freeBucket(uint32_t colorHash) const;
+
+    /**
+     * Remove the bucket of an entry, moving later buckets of the same probe sequences back. Requires m_cacheMutex.
+     */
+    void removeBucket(size_t entryIndex) const;
+
+    /**
+     * Drop all entries without handle and parse the ones with handle again.
+     */
+    void reparseCache();
+
     LightweightMap<HslwColor> m_namedColors;
+
+    mutable std::mutex m_cacheMutex;
+    mutable std::array<Entry, CacheSize> m_entries{};
+    mutable std::array<uint8_t, BucketCount> m_buckets{};
+    mutable size_t m_handleCount{0};
+    mutable size_t m_clockHand{0};
 };
 }
@@ -0,0 +1,79 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace Led {
+/**
+ * Compositing layers of an LED string. Layers are composited bottom to top, so an animation on a higher layer is
+ * always drawn over the animations of the lower layers no matter when either of them was started or ends.
+ */
+enum class Layer : uint8_t {
+    /**
+     * Regular animations. Finished blend animations on any layer write their final color into the base color.
+     */
+    Base,
+    Blend1,
+    Blend2,
+
+    /**
+     * Additive effects on top of everything else.
+     */
+    Overlay,
+
+    /**
+     * Use @link Layer::Overlay for additive and @link Layer::Base for all other animations.
+     */
+    Auto = 0xff,
+
+    /**
+     * Returned by @link layerFromName for unknown names. Not a valid layer for animations.
+     */
+    Invalid = 0xfe,
+};
+
+static constexpr size_t LayerCount = 4;
+
+/**
+ * Maximum number of concurrently running animations per layer and LED string. Adding an animation to a full layer
+ * drops the oldest animation of that layer.
+ */
+static constexpr size_t SlotsPerLayer = 16;
+
+inline Layer layerFromName(const char* name) {
+    if (strcmp(name, "base") == 0) {
+        return Layer::Base;
+    }
+    if (strcmp(name, "blend1") == 0) {
+        return Layer::Blend1;
+    }
+    if (strcmp(name, "blend2") == 0) {
+        return Layer::Blend2;
+    }
+    if (strcmp(name, "overlay") == 0) {
+        return Layer::Overlay;
+    }
+    if (strcmp(name, "auto") == 0) {
+        return Layer::Auto;
+    }
+    return Layer::Invalid;
+}
+}
@@ -32,7 +32,13 @@ class LedManager {
 public:
     explicit LedManager(std::shared_ptr<KeyValueStore> keyValueStore, std::shared_ptr<Led::ColorManager> colorManager, const std::shared_ptr<Js>& js);
 
-    std::shared_ptr<LedView> getLedViewByName(const std::string& name);
+    std::shared_ptr<LedView> getLedViewByName(const char* name);
+
+    /**
+     * @param id Index of the view in @link getLedViews.
+     * @return The view or null if no such view exists.
+     */
+    std::shared_ptr<LedView> getLedViewById(uint16_t id) const;
 
     const std::vector<LightweightMap<std::shared_ptr<LedView> >::entry_t>& getLedViews() const {
         return m_ledViews.getEntries();
@@ -40,6 +46,10 @@ public:
 
     void addLedView(const std::string& name, std::shared_ptr<LedView> ledView);
 
+    const std::shared_ptr<Led::ColorManager>& getColorManager() const {
+        return m_colorManager;
+    }
+
     void loadLedsFromConfig(const std::string& ledPath);
 
     const ModelLocation& getModelLocation() const {
@@ -52,6 +62,12 @@ public:
 
     void stopAllAnimations() const;
 
+    void setMasterBrightness(float brightness) const;
+
+    float getMasterBrightness() const {
+        return m_masterBrightness->value();
+    }
+
     void setManualMode(bool enable, bool save = false) const;
 
     bool isManualMode() const {
@@ -75,6 +91,7 @@ private:
     std::shared_ptr<KeyValueStore::SimpleValue<bool>> m_manualModeOnStartup;
     std::shared_ptr<KeyValueStore::SimpleValue<bool>> m_manualMode;
     std::shared_ptr<KeyValueStore::SimpleValue<bool>> m_startupAnimationEnabled;
+    std::shared_ptr<KeyValueStore::SimpleValue<float>> m_masterBrightness;
     std::shared_ptr<Led::ColorManager> m_colorManager;
     std::vector<std::shared_ptr<LedString> > m_ledStrings;
     LightweightMap<std::shared_ptr<LedView> > m_ledViews;
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <string>
+#include <vector>
 
 // trim from start (in place)
 inline void ltrim(std::string& s) {
@@ -56,3 +62,153 @@ inline std::vector<std::string> split_str(const std::string& string, char delimi
     }
     return strings;
 }
+
+// The following functions work on the range [begin, end) which does not have to be null terminated and never allocate.
+
+inline const char* find_char(const char* begin, const char* end, char c) {
+    while (begin != end && *begin != c) {
+        ++begin;
+    }
+    return begin;
+}
+
+inline void trim(const char*& begin, const char*& end) {
+    while (begin != end && std::isspace(static_cast<unsigned char>(*begin))) {
+        ++begin;
+    }
+    while (end != begin && std::isspace(static_cast<unsigned char>(*(end - 1)))) {
+        --end;
+    }
+}
+
+inline void ltrim(const char*& begin, const char* end, char c) {
+    while (begin != end && *begin == c) {
+        ++begin;
+    }
+}
+
+inline void rtrim(const char* begin, const char*& end, char c) {
+    while (end != begin && *(end - 1) == c) {
+        --end;
+    }
+}
+
+inline void trim(const char*& begin, const char*& end, char c) {
+    ltrim(begin, end, c);
+    rtrim(begin, end, c);
+}
+
+inline bool ends_with(const char* begin, const char* end, const char* ending) {
+    size_t endingSize = strlen(ending);
+    return static_cast<size_t>(end - begin) >= endingSize && memcmp(end - endingSize, ending, endingSize) == 0;
+}
+
+// Like strtoul with base 0: Leading whitespace and an optional sign are skipped, 0x prefixes hex and 0 octal numbers.
+// Overflow saturates at ULONG_MAX and a minus sign negates the value in unsigned arithmetic. If there are no digits,
+// parsedEnd is set to begin.
+inline unsigned long parse_ulong(const char* begin, const char* end, const char** parsedEnd = nullptr) {
+    const char* start = begin;
+    while (begin != end && std::isspace(static_cast<unsigned char>(*begin))) {
+        ++begin;
+    }
+    bool negative = false;
+    if (begin != end && (*begin == '-' || *begin == '+')) {
+        negative = *begin == '-';
+        ++begin;
+    }
+    unsigned long base = 10;
+    if (begin != end && *begin == '0') {
+        base = 8;
+        if (end - begin > 2 && (begin[1] == 'x' || begin[1] == 'X') && std::isxdigit(static_cast<unsigned char>(begin[2]))) {
+            base = 16;
+            begin += 2;
+        }
+    }
+    const char* digitsBegin = begin;
+    unsigned long value = 0;
+    bool overflow = false;
+    for (; begin != end; ++begin) {
+        unsigned long digit;
+        if (*begin >= '0' && *begin <= '9') {
+            digit = *begin - '0';
+        } else if (*begin >= 'a' && *begin <= 'f') {
+            digit = *begin - 'a' + 10;
+        } else if (*begin >= 'A' && *begin <= 'F') {
+            digit = *begin - 'A' + 10;
+        } else {
+            break;
+        }
+        if (digit >= base) {
+            break;
+        }
+        if (value > (ULONG_MAX - digit) / base) {
+            overflow = true;
+        }
+        value = value * base + digit;
+    }
+    if (parsedEnd != nullptr) {
+        *parsedEnd = begin == digitsBegin ? start : begin;
+    }
+    if (overflow) {
+        return ULONG_MAX;
+    }
+    return negative ? -value : value;
+}
+
+// Decimal floats with optional sign, fraction and exponent. Leading whitespace is skipped. Digits are accumulated in
+// float, so results may differ from strtof by a few ULP. Hex floats, inf and nan are not supported. If there are no
+// digits, parsedEnd is set to begin.
+inline float parse_float(const char* begin, const char* end, const char** parsedEnd = nullptr) {
+    const char* start = begin;
+    while (begin != end && std::isspace(static_cast<unsigned char>(*begin))) {
+        ++begin;
+    }
+    bool negative = false;
+    if (begin != end && (*begin == '-' || *begin == '+')) {
+        negative = *begin == '-';
+        ++begin;
+    }
+    float value = 0;
+    bool hasDigits = false;
+    for (; begin != end && *begin >= '0' && *begin <= '9'; ++begin) {
+        value = value * 10 + static_cast<float>(*begin - '0');
+        hasDigits = true;
+    }
+    if (begin != end && *begin == '.') {
+        float factor = 0.1f;
+        for (++begin; begin != end && *begin >= '0' && *begin <= '9'; ++begin) {
+            value += factor * static_cast<float>(*begin - '0');
+            factor *= 0.1f;
+            hasDigits = true;
+        }
+    }
+    if (!hasDigits) {
+        if (parsedEnd != nullptr) {
+            *parsedEnd = start;
+        }
+        return 0;
+    }
+    if (begin != end && (*begin == 'e' || *begin == 'E')) {
+        const char* exponentBegin = begin + 1;
+        bool negativeExponent = false;
+        if (exponentBegin != end && (*exponentBegin == '-' || *exponentBegin == '+')) {
+            negativeExponent = *exponentBegin == '-';
+            ++exponentBegin;
+        }
+        if (exponentBegin != end && *exponentBegin >= '0' && *exponentBegin <= '9') {
+            int exponent = 0;
+            for (begin = exponentBegin; begin != end && *begin >= '0' && *begin <= '9'; ++begin) {
+                if (exponent < 100) {
+                    exponent = exponent * 10 + (*begin - '0');
+                }
+            }
+            for (; exponent > 0; exponent--) {
+                value = negativeExponent ? value / 10 : value * 10;
+            }
+        }
+    }
+    if (parsedEnd != nullptr) {
+        *parsedEnd = begin;
+    }
+    return negative ? -value : value;
+}
@@ -18,13 +18,15 @@
 
 #pragma once
 
-#include <list>
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <NeoPixelBus.h>
 #include <random>
 
 #include "LedView.h"
 #include "Led/Animation.h"
+#include "Led/Layer.h"
 #include "Led/Led.h"
 
 class LedString : public LedView {
@@ -77,6 +79,16 @@ public:
 
     void endAllAnimations() const;
 
+    /**
+     * Set the brightness all layers are scaled with after compositing. Unlike the view brightness this also
+     * applies to already running animations and the current base colors.
+     */
+    void setMasterBrightness(float brightness);
+
+    float getMasterBrightness() const {
+        return static_cast<float>(m_masterBrightness) / 255.f;
+    }
+
     void update();
 
 protected:
@@ -85,8 +97,22 @@ protected:
     virtual void showLeds() = 0;
 
 private:
+    struct AnimationLayer {
+        /**
+         * Running animations of this layer in the order they were added. Only the first @link count slots are used.
+         */
+        std::array<std::unique_ptr<Led::Animation>, Led::SlotsPerLayer> slots{};
+        uint8_t count{0};
+    };
+
     static void ensureColorBufferSize(led_index_t size);
 
+    /**
+     * Write the color an animation ends with into the base color of its LEDs. Only the contribution of this animation
+     * is applied, so animations still running below or beside it are not baked in. Requires m_animationsMutex.
+     */
+    void applyFinalColor(const Led::Animation& animation);
+
     static void updateTimerFn(TimerHandle_t timer) {
         static_cast<LedString*>(pvTimerGetTimerID(timer))->update();
     }
@@ -97,8 +123,13 @@ private:
     std::vector<Led::Led> m_leds;
 
     std::chrono::system_clock::time_point m_manualAnimationReleaseTime;
-    std::list<std::unique_ptr<Led::Animation> > m_animations;
+    std::array<AnimationLayer, Led::LayerCount> m_layers{};
     std::mutex m_animationsMutex;
+    /**
+     * Written under m_animationsMutex, atomic for the unlocked @link getMasterBrightness.
+     */
+    std::atomic<uint8_t> m_masterBrightness{255};
+    bool m_redrawRequested{false};
 
     TimerHandle_t m_updateTimer;
 
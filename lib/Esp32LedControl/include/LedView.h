@@ -19,6 +19,7 @@
 #pragma once
 
 #include "Led/Animation.h"
+#include "Led/Layer.h"
 
 #include <ArduinoJson.h>
 #include <KeyValueStore.h>
@@ -50,6 +51,7 @@ public:
 
         AnimationType animationType{AnimationType::Linear};
         Led::Blending blending{Led::Blending::Blend};
+        Led::Layer layer{Led::Layer::Auto};
         ease_func_t easing{&Easing::easeLinear};
         std::string targetColorStr;
         Led::HslwColor targetColor;
@@ -18,8 +18,7 @@
 
 #include "Easing.h"
 
-#include <map>
-#include <vector>
+#include <cstring>
 
 const std::array<ease_func_t, 30> easeFunctions = {
         &Easing::easeLinear,
@@ -54,43 +53,44 @@ const std::array<ease_func_t, 30> easeFunctions = {
         &Easing::easeInOutBounce,
 };
 
-static const std::map<std::string, int> nameMap = {
-        {"easeLinear", 0},
-        {"easeInQuad", 1},
-        {"easeOutQuad", 2},
-        {"easeInOutQuad", 3},
-        {"easeInCubic", 4},
-        {"easeOutCubic", 5},
-        {"easeInOutCubic", 6},
-        {"easeInQuart", 7},
-        {"easeOutQuart", 8},
-        {"easeInOutQuart", 9},
-        {"easeInQuint", 10},
-        {"easeOutQuint", 11},
-        {"easeInOutQuint", 12},
-        {"easeInSine", 13},
-        {"easeOutSine", 14},
-        {"easeInOutSine", 15},
-        {"easeInExpo", 16},
-        {"easeOutExpo", 17},
-        {"easeInOutExpo", 18},
-        {"easeInCirc", 19},
-        {"easeOutCirc", 20},
-        {"easeInOutCirc", 21},
-        {"easeInElastic", 22},
-        {"easeOutElastic", 23},
-        {"easeInOutElastic", 24},
-        {"easeInBack", 25},
-        {"easeOutBack", 26},
-        {"easeInOutBack", 27},
-        {"easeInBounce", 28},
-        {"easeInOutBounce", 29},
+static const std::array<const char*, 30> easeNames = {
+        "easeLinear",
+        "easeInQuad",
+        "easeOutQuad",
+        "easeInOutQuad",
+        "easeInCubic",
+        "easeOutCubic",
+        "easeInOutCubic",
+        "easeInQuart",
+        "easeOutQuart",
+        "easeInOutQuart",
+        "easeInQuint",
+        "easeOutQuint",
+        "easeInOutQuint",
+        "easeInSine",
+        "easeOutSine",
+        "easeInOutSine",
+        "easeInExpo",
+        "easeOutExpo",
+        "easeInOutExpo",
+        "easeInCirc",
+        "easeOutCirc",
+        "easeInOutCirc",
+        "easeInElastic",
+        "easeOutElastic",
+        "easeInOutElastic",
+        "easeInBack",
+        "easeOutBack",
+        "easeInOutBack",
+        "easeInBounce",
+        "easeInOutBounce",
 };
 
-ease_func_t Easing::getFuncByName(const std::string& name) {
-    auto func = nameMap.find(name);
-    if (func != nameMap.end()) {
-        return easeFunctions[func->second];
+ease_func_t Easing::getFuncByName(const char* name) {
+    for (size_t i = 0; i < easeNames.size(); i++) {
+        if (strcmp(easeNames[i], name) == 0) {
+            return easeFunctions[i];
+        }
     }
     return &Easing::easeLinear;
 }
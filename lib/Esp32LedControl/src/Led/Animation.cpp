@@ -24,32 +24,34 @@
 
 namespace Led {
 
-inline bool ends_with(std::string const & value, std::string const & ending)
-{
-    if (ending.size() > value.size()) return false;
-    return std::equal(ending.rbegin(), ending.rend(), value.rbegin());
+Animation::RndDuration Animation::parseDuration(const std::string& durationStr) {
+    return parseDuration(durationStr.data(), durationStr.data() + durationStr.size());
 }
 
-Animation::RndDuration Animation::parseDuration(std::string durationStr) {
-    if (durationStr.empty()) {
+Animation::RndDuration Animation::parseDuration(const char* durationStr) {
+    return parseDuration(durationStr, durationStr + strlen(durationStr));
+}
+
+Animation::RndDuration Animation::parseDuration(const char* begin, const char* end) {
+    if (begin == end) {
         return {};
     }
 
     bool delayIsGlobal = false;
-    if (durationStr.front() == '=') {
+    if (*begin == '=') {
         delayIsGlobal = true;
-        durationStr.erase(durationStr.begin());
+        ++begin;
     }
 
-    if (durationStr.size() > 2 && durationStr[0] == '[') {
-        ltrim(durationStr, '[');
-        rtrim(durationStr, ']');
-        auto minMaxValue = split_str(durationStr, ',');
-        if (minMaxValue.size() != 2) {
+    if (end - begin > 2 && *begin == '[') {
+        ltrim(begin, end, '[');
+        rtrim(begin, end, ']');
+        const char* comma = find_char(begin, end, ',');
+        if (comma == end || find_char(comma + 1, end, ',') != end) {
             return {};
         }
-        auto minValue = parseDuration(minMaxValue[0]);
-        auto maxValue = parseDuration(minMaxValue[1]);
+        auto minValue = parseDuration(begin, comma);
+        auto maxValue = parseDuration(comma + 1, end);
 
         return {
             minValue.eval(1),
@@ -59,12 +61,12 @@ Animation::RndDuration Animation::parseDuration(std::string durationStr) {
         };
     }
 
-    char* endOfNumber = nullptr;
-    auto number = std::strtoul(durationStr.c_str(), &endOfNumber, 0);
-    if (endOfNumber[0] == 's') {
+    const char* endOfNumber = begin;
+    auto number = parse_ulong(begin, end, &endOfNumber);
+    if (endOfNumber != end && *endOfNumber == 's') {
         number *= 1000;
     }
-    bool perLed = !ends_with(endOfNumber, "/n");
+    bool perLed = !ends_with(endOfNumber, end, "/n");
     return {durationFromMs(number), durationFromMs(number), perLed, delayIsGlobal};
 }
 }
@@ -5,17 +5,168 @@
 #include <LedStrUtils.h>
 
 namespace Led {
+constexpr uint8_t ColorManager::EmptyBucket;
 
 void ColorManager::loadColorsFromConfig(const std::string& namedColorPath) {
     JsonDocument json;
     std::ifstream file{namedColorPath};
     deserializeJson(json, file);
     for (const auto& color: json.as<JsonObjectConst>()) {
-        m_namedColors.set(color.key().c_str(), parseColor(color.value()));
+        m_namedColors.set(color.key().c_str(), resolve(parseSpec(color.value()), {{0, 0, 0}, 0, 0}));
     }
+    // Named colors are resolved when a color string is parsed, so all cached colors may be outdated now.
+    reparseCache();
+}
+
+ColorManager::handle_t ColorManager::intern(const std::string& colorString) const {
+    if (!colorString.empty() && colorString[0] == '@') {
+        auto handle = static_cast<handle_t>(strtoul(colorString.c_str() + 1, nullptr, 10));
+        std::lock_guard<std::mutex> lock{m_cacheMutex};
+        return isHandle(handle) ? handle : InvalidHandle;
+    }
+    ColorSpec spec;
+    return findOrInsert(colorString, &spec, true);
+}
+
+HslwColor ColorManager::resolve(handle_t handle, const HslwColor& primaryColor) const {
+    ColorSpec spec;
+    {
+        std::lock_guard<std::mutex> lock{m_cacheMutex};
+        if (!isHandle(handle)) {
+            return {0};
+        }
+        spec = m_entries[handle].spec;
+    }
+    return resolve(spec, primaryColor);
 }
 
 HslwColor ColorManager::parseColor(const std::string& colorString, const HslwColor& primaryColor) const {
+    if (!colorString.empty() && colorString[0] == '@') {
+        return resolve(static_cast<handle_t>(strtoul(colorString.c_str() + 1, nullptr, 10)), primaryColor);
+    }
+    ColorSpec spec;
+    findOrInsert(colorString, &spec, false);
+    return resolve(spec, primaryColor);
+}
+
+uint32_t ColorManager::hash(const std::string& colorString) {
+    // FNV-1a
+    uint32_t result = 2166136261u;
+    for (char c: colorString) {
+        result ^= static_cast<uint8_t>(c);
+        result *= 16777619u;
+    }
+    return result;
+}
+
+ColorManager::handle_t ColorManager::findOrInsert(const std::string& colorString, ColorSpec* spec,
+                                                  const bool pin) const {
+    uint32_t colorHash = hash(colorString);
+    std::lock_guard<std::mutex> lock{m_cacheMutex};
+    size_t bucket = colorHash % BucketCount;
+    while (m_buckets[bucket] != EmptyBucket) {
+        Entry& entry = m_entries[m_buckets[bucket]];
+        if (entry.hash == colorHash && entry.colorString == colorString) {
+            *spec = entry.spec;
+            entry.isReferenced = true;
+            if (pin && !entry.isPinned) {
+                if (m_handleCount == MaximumHandles) {
+                    return InvalidHandle;
+                }
+                entry.isPinned = true;
+                m_handleCount++;
+            }
+            return m_buckets[bucket];
+        }
+        bucket = (bucket + 1) % BucketCount;
+    }
+
+    *spec = parseSpec(colorString);
+    if (pin && m_handleCount == MaximumHandles) {
+        return InvalidHandle;
+    }
+    const size_t index = evictEntry();
+    Entry& entry = m_entries[index];
+    entry.colorString = colorString;
+    entry.hash = colorHash;
+    entry.spec = *spec;
+    entry.isUsed = true;
+    entry.isPinned = pin;
+    entry.isReferenced = true;
+    if (pin) {
+        m_handleCount++;
+    }
+    // Evicting moves buckets, so the free bucket found above may be outdated.
+    m_buckets[freeBucket(colorHash)] = static_cast<uint8_t>(index);
+    return static_cast<handle_t>(index);
+}
+
+size_t ColorManager::evictEntry() const {
+    // At most MaximumHandles entries are pinned, so the hand finds an entry within two rounds.
+    while (true) {
+        const size_t index = m_clockHand;
+        m_clockHand = (m_clockHand + 1) % CacheSize;
+        Entry& entry = m_entries[index];
+        if (!entry.isUsed) {
+            return index;
+        }
+        if (entry.isPinned) {
+            continue;
+        }
+        if (entry.isReferenced) {
+            entry.isReferenced = false;
+            continue;
+        }
+        removeBucket(index);
+        entry.isUsed = false;
+        return index;
+    }
+}
+
+size_t ColorManager::freeBucket(const uint32_t colorHash) const {
+    size_t bucket = colorHash % BucketCount;
+    while (m_buckets[bucket] != EmptyBucket) {
+        bucket = (bucket + 1) % BucketCount;
+    }
+    return bucket;
+}
+
+void ColorManager::removeBucket(const size_t entryIndex) const {
+    size_t hole = m_entries[entryIndex].hash % BucketCount;
+    while (m_buckets[hole] != entryIndex) {
+        hole = (hole + 1) % BucketCount;
+    }
+    size_t bucket = (hole + 1) % BucketCount;
+    while (m_buckets[bucket] != EmptyBucket) {
+        const size_t home = m_entries[m_buckets[bucket]].hash % BucketCount;
+        // Move the bucket into the hole unless its probe sequence starts after the hole.
+        if ((bucket + BucketCount - home) % BucketCount >= (bucket + BucketCount - hole) % BucketCount) {
+            m_buckets[hole] = m_buckets[bucket];
+            hole = bucket;
+        }
+        bucket = (bucket + 1) % BucketCount;
+    }
+    m_buckets[hole] = EmptyBucket;
+}
+
+void ColorManager::reparseCache() {
+    std::lock_guard<std::mutex> lock{m_cacheMutex};
+    m_buckets.fill(EmptyBucket);
+    for (size_t i = 0; i < CacheSize; i++) {
+        Entry& entry = m_entries[i];
+        if (!entry.isPinned) {
+            entry.isUsed = false;
+            entry.colorString.clear();
+            entry.colorString.shrink_to_fit();
+            continue;
+        }
+        entry.spec = parseSpec(entry.colorString);
+        m_buckets[freeBucket(entry.hash)] = static_cast<uint8_t>(i);
+    }
+}
+
+ColorManager::ColorSpec ColorManager::parseSpec(const std::string& colorString) const {
+    ColorSpec spec;
     size_t bracketPosition = colorString.find_first_of('(');
     size_t bracket2Position = colorString.find_first_of(')');
     std::string colorType;
@@ -34,7 +185,7 @@ HslwColor ColorManager::parseColor(const std::string& colorString, const HslwCol
         size_t firstCommaPosition = colorValueStr.find_first_of(',');
         size_t lastCommaPosition = colorValueStr.find_last_of(',');
         if (firstCommaPosition == std::string::npos || lastCommaPosition == std::string::npos) {
-            return {0};
+            return spec;
         }
         float r = strtof(colorValueStr.substr(0, firstCommaPosition).c_str(), nullptr);
         float g = strtof(
@@ -49,41 +200,45 @@ HslwColor ColorManager::parseColor(const std::string& colorString, const HslwCol
             g /= max;
             b /= max;
         }
-        return {Rgb48Color{
+        spec.color = {Rgb48Color{
             static_cast<uint16_t>(r * 65535), static_cast<uint16_t>(g * 65535),
             static_cast<uint16_t>(b * 65535)
         }, brightness};
+        return spec;
     }
     if (colorType == "w") {
-        return HslwColor{{0, 0, 0}, static_cast<uint8_t>(255 * strtof(colorValueStr.c_str(), nullptr)), 1};
+        spec.color = HslwColor{{0, 0, 0}, static_cast<uint8_t>(255 * strtof(colorValueStr.c_str(), nullptr)), 1};
+        return spec;
     }
 
     if (colorType == "hsv" || colorType == "hsl") {
         size_t firstCommaPosition = colorValueStr.find_first_of(',');
         size_t lastCommaPosition = colorValueStr.find_last_of(',');
         if (firstCommaPosition == std::string::npos || lastCommaPosition == std::string::npos) {
-            return {0};
+            return spec;
         }
         float h = strtof(colorValueStr.substr(0, firstCommaPosition).c_str(), nullptr);
         float s = strtof(
             colorValueStr.substr(firstCommaPosition + 1, lastCommaPosition - firstCommaPosition - 1).c_str(),
             nullptr);
         float l = strtof(colorValueStr.substr(lastCommaPosition + 1, std::string::npos).c_str(), nullptr);
-        return colorType == "hsv" ? HslColor{Rgb48Color{HsbColor{h, s, l}}} : HslColor{h, s, l};
+        spec.color = colorType == "hsv" ? HslColor{Rgb48Color{HsbColor{h, s, l}}} : HslColor{h, s, l};
+        return spec;
     }
 
-    HslwColor baseColor;
+    float v = colorValueStr.empty() ? 1.f : strtof(colorValueStr.c_str(), nullptr);
     if (colorType == "primary") {
-        baseColor = primaryColor;
-    } else {
-        auto it = m_namedColors.find(colorType.c_str());
-        if (it == m_namedColors.end()) {
-            return {0};
-        }
-        baseColor = it->second;
+        spec.primary = true;
+        spec.intensity = v;
+        return spec;
     }
 
-    float v = colorValueStr.empty() ? 1.f : strtof(colorValueStr.c_str(), nullptr);
-    return {baseColor.hslColor(), static_cast<uint8_t>(static_cast<float>(baseColor.w())), v};
+    auto it = m_namedColors.find(colorType.c_str());
+    if (it == m_namedColors.end()) {
+        return spec;
+    }
+    const HslwColor& baseColor = it->second;
+    spec.color = {baseColor.hslColor(), static_cast<uint8_t>(static_cast<float>(baseColor.w())), v};
+    return spec;
 }
 }
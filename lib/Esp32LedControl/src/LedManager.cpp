@@ -55,11 +55,22 @@ LedManager::LedManager(std::shared_ptr<KeyValueStore> keyValueStore, std::shared
       m_startupAnimationEnabled{
           m_keyValueStore->createValue("Settings", "StartAnimOn", true, true)
       },
+      m_masterBrightness{
+          m_keyValueStore->createValue("Settings", "MasterBright", true, 1.f)
+      },
       m_js{js} {
 }
 
-std::shared_ptr<LedView> LedManager::getLedViewByName(const std::string& name) {
-    return m_ledViews.get(name.c_str());
+std::shared_ptr<LedView> LedManager::getLedViewByName(const char* name) {
+    return m_ledViews.get(name);
+}
+
+std::shared_ptr<LedView> LedManager::getLedViewById(uint16_t id) const {
+    const auto& ledViews = m_ledViews.getEntries();
+    if (id >= ledViews.size()) {
+        return nullptr;
+    }
+    return ledViews[id].second;
 }
 
 void LedManager::addLedView(const std::string& name, std::shared_ptr<LedView> ledView) {
@@ -77,6 +88,14 @@ void LedManager::stopAllAnimations() const {
     }
 }
 
+void LedManager::setMasterBrightness(float brightness) const {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_masterBrightness->setValue(brightness);
+    for (auto& ledString : m_ledStrings) {
+        ledString->setMasterBrightness(brightness);
+    }
+}
+
 void LedManager::setManualMode(bool enable, bool save) const {
     std::unique_lock<std::mutex> lock{m_mutex};
 
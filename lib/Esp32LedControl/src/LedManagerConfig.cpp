@@ -23,18 +23,17 @@
 
 #include <ArduinoJson.h>
 #include <fstream>
+#include <LedStrUtils.h>
 
 using led_index_t = Led::Led::index_t;
 
 #define GET_CONFIG(key, type) if (!ledConfig[#key].is<type>()) { addConfigErrorView(name, #key); continue; } auto key = ledConfig[#key].as<type>();
 #define GET_CONFIG_OPTIONAL(key, type, defaultValue) auto key = ledConfig[#key].is<type>() ? ledConfig[#key].as<type>() : defaultValue;
 
-void appendRange(std::vector<led_index_t>& indices, const std::string& range, size_t sizeLimit) {
-    auto dashPosition = range.find_first_of('-');
-    led_index_t startIndex = strtoul(range.substr(0, dashPosition).c_str(), nullptr, 0);
-    led_index_t endIndex = (dashPosition == std::string::npos)
-                               ? startIndex
-                               : strtoul(range.substr(dashPosition + 1).c_str(), nullptr, 0);
+void appendRange(std::vector<led_index_t>& indices, const char* begin, const char* end, size_t sizeLimit) {
+    const char* dash = find_char(begin, end, '-');
+    led_index_t startIndex = parse_ulong(begin, dash);
+    led_index_t endIndex = (dash == end) ? startIndex : parse_ulong(dash + 1, end);
     while (startIndex != endIndex && indices.size() < sizeLimit) {
         indices.push_back(startIndex);
         startIndex += startIndex > endIndex ? -1 : 1;
@@ -102,7 +101,8 @@ void LedManager::loadLedsFromConfig(const std::string& ledPath) {
                     ledMapVector.push_back(ledMapEntry.as<JsonInteger>());
                 }
                 if (ledMapEntry.is<JsonString>()) {
-                    appendRange(ledMapVector, ledMapEntry.as<JsonString>().c_str(), parentLedCount + 1);
+                    auto range = ledMapEntry.as<JsonString>();
+                    appendRange(ledMapVector, range.c_str(), range.c_str() + range.size(), parentLedCount + 1);
                 }
                 if (ledMapVector.size() > parentLedCount) {
                     break;
@@ -227,6 +227,7 @@ void LedManager::loadLedsFromConfig(const std::string& ledPath) {
         }
         addLedView(name, ledView);
         if (ledString) {
+            ledString->setMasterBrightness(m_masterBrightness->value());
             m_ledStrings.emplace_back(ledString);
         }
     }
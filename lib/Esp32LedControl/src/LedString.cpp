@@ -117,43 +117,75 @@ void LedString::addAnimation(std::unique_ptr<AnimationConfig> config) {
         updateAnimationTargetColor(config->targetColor, endTime);
     }
 
-    std::unique_lock<std::mutex> animationsLock{m_animationsMutex};
-
-    auto it = config->blending != Led::Blending::Add ? m_animations.begin() : m_animations.end();
-    while (it != m_animations.end()) {
-        const auto& animation = it->get();
-        if (endTime < animation->endTime || animation->blending == Led::Blending::Add) {
-            break;
-        }
-        ++it;
+    auto layerIndex = static_cast<size_t>(config->layer);
+    if (config->layer == Led::Layer::Auto) {
+        layerIndex = static_cast<size_t>(
+            config->blending == Led::Blending::Add ? Led::Layer::Overlay : Led::Layer::Base);
     }
-    m_animations.emplace(
-        it,
-        std::unique_ptr<Animation>(new Animation{
+    if (layerIndex >= Led::LayerCount) {
+        layerIndex = Led::LayerCount - 1;
+    }
+
+    std::unique_ptr<Animation> animation{
+        new Animation{
             .blending = config->blending,
             .easing = config->easing,
-            .targetColor = config->targetColor,
+            .targetColor = config->targetColor.toRgbwColor(),
             .startTime = startTime,
             .endTime = endTime,
             .halfCycles = config->halfCycles,
             .leds = std::move(perLedData),
-        }));
+        }
+    };
+
+    std::unique_lock<std::mutex> animationsLock{m_animationsMutex};
+    auto& layer = m_layers[layerIndex];
+    if (layer.count == layer.slots.size()) {
+        // Layer is full, make room by dropping the oldest animation. Like a completed animation it leaves its final
+        // color in the base color, otherwise the LEDs would jump back to the color from before it started.
+        applyFinalColor(*layer.slots[0]);
+        m_redrawRequested = true;
+        std::move(layer.slots.begin() + 1, layer.slots.end(), layer.slots.begin());
+        layer.count--;
+    }
+    layer.slots[layer.count++] = std::move(animation);
+}
+
+void LedString::applyFinalColor(const Animation& animation) {
+    if (animation.blending == Led::Blending::Add) {
+        return;
+    }
+    const float finalProgress = animation.easing(animation.halfCycles % 2 ? 1.f : 0.f);
+    for (const auto& led: animation.leds) {
+        auto& baseColor = m_leds[led.ledIndex].currentBaseColor;
+        baseColor = RgbwColor::LinearBlend(baseColor, animation.targetColor,
+                                           finalProgress * (static_cast<float>(led.ledBrightnessFactor) / 65535.f));
+    }
 }
 
 void LedString::endAllAnimations() const {
     auto now = std::chrono::system_clock::now();
-    for (const auto& animation: m_animations) {
-        animation->endTime = now;
-        for (const auto& ledViewWeak: animation->affectedLedViews) {
-            auto ledView = ledViewWeak.lock();
-            if (!ledView) {
-                continue;
+    for (const auto& layer: m_layers) {
+        for (size_t slot = 0; slot < layer.count; slot++) {
+            const auto& animation = layer.slots[slot];
+            animation->endTime = now;
+            for (const auto& ledViewWeak: animation->affectedLedViews) {
+                auto ledView = ledViewWeak.lock();
+                if (!ledView) {
+                    continue;
+                }
+                ledView->setCurrentAnimationEnd(now);
             }
-            ledView->setCurrentAnimationEnd(now);
         }
     }
 }
 
+void LedString::setMasterBrightness(float brightness) {
+    std::unique_lock<std::mutex> animationsLock{m_animationsMutex};
+    m_masterBrightness = static_cast<uint8_t>(std::min(255.f, std::max(0.f, brightness * 255.f)));
+    m_redrawRequested = true;
+}
+
 void LedString::update() {
     std::unique_lock<std::mutex> colorBufferLock{colorBufferMutex};
     for (led_index_t i = 0; i < m_ledCount; i++) {
@@ -163,68 +195,73 @@ void LedString::update() {
 
     const auto now = std::chrono::system_clock::now();
     std::unique_lock<std::mutex> animationsLock{m_animationsMutex};
-    bool anyAnimationActive = false;
-    for (auto it = m_animations.begin(); it != m_animations.end();) {
-        auto& animation = *it;
-        if (now < animation->startTime) {
-            it++;
-            continue;
-        }
-        auto targetColor = animation->targetColor.toRgbwColor();
-        bool animationFinishes = animation->endTime <= now;
-        for (size_t i = 0; i < animation->leds.size(); i++) {
-            Animation::PerLed& led = animation->leds[i];
-
-            auto ledStartTime = animation->startTime + led.ledDelay;
-            if (now < ledStartTime) {
+    bool anyAnimationActive = m_redrawRequested;
+    for (auto& layer: m_layers) {
+        uint8_t keptAnimations = 0;
+        for (uint8_t slot = 0; slot < layer.count; slot++) {
+            auto& animation = layer.slots[slot];
+            if (now < animation->startTime) {
+                std::swap(layer.slots[keptAnimations++], animation);
                 continue;
             }
-            auto animationTimeRunning = std::chrono::duration_cast<Led::Animation::duration>(now - ledStartTime);
-
-            led_index_t ledIndex = led.ledIndex;
-            auto& ledColor = colorBuffer[ledIndex];
-            float animationProgress = led.ledDuration.count() > 0 ? std::min(
-                1.f, static_cast<float>(animationTimeRunning.count()) /
-                     static_cast<float>(led.ledDuration.count())
-            ) : 1.f;
-
-            animationProgress *= static_cast<float>(animation->halfCycles);
-            const int animationCycle = static_cast<int>(animationProgress);
-            animationProgress -= static_cast<float>(animationCycle);
-            if (animationCycle % 2) {
-                animationProgress = 1 - animationProgress;
-            }
+            const RgbwColor& targetColor = animation->targetColor;
+            bool animationFinishes = animation->endTime <= now;
+            for (size_t i = 0; i < animation->leds.size(); i++) {
+                Animation::PerLed& led = animation->leds[i];
+
+                auto ledStartTime = animation->startTime + led.ledDelay;
+                if (now < ledStartTime) {
+                    continue;
+                }
+                auto animationTimeRunning = std::chrono::duration_cast<Led::Animation::duration>(now - ledStartTime);
 
-            float blendValue = animation->easing(animationProgress) * (static_cast<float>(led.ledBrightnessFactor) / 65535.f);
-            switch (animation->blending) {
-                case Led::Blending::Blend:
-                    ledColor = RgbwColor::LinearBlend(ledColor, targetColor, blendValue);
+                led_index_t ledIndex = led.ledIndex;
+                auto& ledColor = colorBuffer[ledIndex];
+                float animationProgress = led.ledDuration.count() > 0 ? std::min(
+                    1.f, static_cast<float>(animationTimeRunning.count()) /
+                         static_cast<float>(led.ledDuration.count())
+                ) : 1.f;
+
+                animationProgress *= static_cast<float>(animation->halfCycles);
+                const int animationCycle = static_cast<int>(animationProgress);
+                animationProgress -= static_cast<float>(animationCycle);
+                if (animationCycle % 2) {
+                    animationProgress = 1 - animationProgress;
+                }
+
+                float blendValue = animation->easing(animationProgress) * (static_cast<float>(led.ledBrightnessFactor) / 65535.f);
+                switch (animation->blending) {
+                    case Led::Blending::Blend:
+                        ledColor = RgbwColor::LinearBlend(ledColor, targetColor, blendValue);
+                        break;
+                    case Led::Blending::Add: {
+                        auto addColor = RgbwColor::LinearBlend({0, 0, 0}, targetColor, blendValue);
+                        ledColor = RgbwColor(
+                            std::min(255, ledColor.R + addColor.R),
+                            std::min(255, ledColor.G + addColor.G),
+                            std::min(255, ledColor.B + addColor.B),
+                            std::min(255, ledColor.W + addColor.W)
+                        );
+                    }
                     break;
-                case Led::Blending::Add: {
-                    auto addColor = RgbwColor::LinearBlend({0, 0, 0}, targetColor, blendValue);
-                    ledColor = RgbwColor(
-                        std::min(255, ledColor.R + addColor.R),
-                        std::min(255, ledColor.G + addColor.G),
-                        std::min(255, ledColor.B + addColor.B),
-                        std::min(255, ledColor.W + addColor.W)
-                    );
                 }
-                break;
-            }
-            colorBufferUpdated[ledIndex] = true;
-            if (animationFinishes && animation->blending != Led::Blending::Add) {
-                m_leds[ledIndex].currentBaseColor = ledColor;
+                colorBufferUpdated[ledIndex] = true;
+                anyAnimationActive = true;
             }
 
-            anyAnimationActive = true;
-        }
-
-        if (animationFinishes) {
-            it = m_animations.erase(it);
-        } else {
-            ++it;
+            if (animationFinishes) {
+                // Only keep the own final color, ledColor also contains animations that are still running.
+                applyFinalColor(*animation);
+                animation.reset();
+            } else {
+                std::swap(layer.slots[keptAnimations++], animation);
+            }
         }
+        layer.count = keptAnimations;
     }
+    const bool redrawAll = m_redrawRequested;
+    m_redrawRequested = false;
+    const uint8_t masterBrightness = m_masterBrightness;
     animationsLock.unlock();
 
     if (!anyAnimationActive) {
@@ -233,10 +270,10 @@ void LedString::update() {
 
     bool shouldShowLeds = false;
     for (led_index_t i = 0; i < m_ledCount; i++) {
-        if (!colorBufferUpdated[i]) {
+        if (!colorBufferUpdated[i] && !redrawAll) {
             continue;
         }
-        setLedColor(i, colorBuffer[i]);
+        setLedColor(i, masterBrightness == 255 ? colorBuffer[i] : colorBuffer[i].Dim(masterBrightness));
         shouldShowLeds = true;
     }
     if (shouldShowLeds) {
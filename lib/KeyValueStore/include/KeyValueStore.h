@@ -48,6 +48,17 @@ public:
             return m_name;
         }
 
+        /**
+         * Position of the value in its store, values are numbered in order of creation.
+         */
+        size_t index() const {
+            return m_index;
+        }
+
+        bool isPersistent() const {
+            return m_persistenceStatus != Volatile;
+        }
+
         size_t writeToBuffer(uint8_t* buffer, size_t bufferSize, size_t* requiredBufferSize = nullptr) const {
             auto lock = acquireLock();
             const size_t nameSize = strlen(m_name) + 1;
@@ -69,6 +80,27 @@ public:
             return capacityRequired;
         }
 
+        /**
+         * Write only the value as [size: uint8][value], without the name.
+         */
+        size_t writeValueToBuffer(uint8_t* buffer, size_t bufferSize, size_t* requiredBufferSize = nullptr) const {
+            auto lock = acquireLock();
+            size_t valueSize = getValueSize();
+            assert(valueSize < 255);
+            size_t capacityRequired = 1 + valueSize;
+            if (requiredBufferSize != nullptr) {
+                *requiredBufferSize = capacityRequired;
+            }
+            if (bufferSize < capacityRequired) {
+                return 0;
+            }
+            buffer[0] = static_cast<uint8_t>(valueSize);
+            if (writeValue(buffer + 1, bufferSize - 1) != valueSize) {
+                return 0;
+            }
+            return capacityRequired;
+        }
+
     protected:
         std::unique_lock<std::mutex> acquireLock() const {
             return std::unique_lock<std::mutex>(m_mutex);
@@ -101,6 +133,7 @@ public:
         char* m_key;
         char* m_name;
         PersistenceStatus m_persistenceStatus;
+        size_t m_index{0};
     };
 
     template<typename T>
@@ -162,6 +195,7 @@ public:
         auto value = std::make_shared<SimpleValue<T> >(
             this, valueNamespace, valueKey, isPersistent, defaultValue, Value::Private{}
         );
+        value->m_index = m_values.size();
         m_values.emplace_back(value);
         return value;
     }
@@ -178,6 +212,31 @@ public:
         m_valueChangeCallbacks.erase(ownerPtr);
     }
 
+    std::shared_ptr<const Value> findValue(const char* name) const {
+        auto lock = acquireLock();
+        for (const auto& value: m_values) {
+            if (strcmp(value->name(), name) == 0) {
+                return value;
+            }
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<const Value> getValue(size_t index) const {
+        auto lock = acquireLock();
+        if (index >= m_values.size()) {
+            return nullptr;
+        }
+        return m_values[index];
+    }
+
+    void forEachValue(const std::function<void(const std::shared_ptr<const Value>&)>& fn) const {
+        auto lock = acquireLock();
+        for (const auto& value: m_values) {
+            fn(value);
+        }
+    }
+
     void writeAllValuesToStream(Stream& stream) const;
 
 private:
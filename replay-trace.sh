@@ -0,0 +1,36 @@
+#!/bin/bash
+
+set -eu
+
+if [[ $# -lt 1 ]] || [[ $# -gt 2 ]]; then
+    >&2 printf 'Usage: %s <trace_dump> [<client_id>]\nWrites the commands of a "trace dump" output to stdout with their original timing.\nPipe it to the device, e.g. %s trace.txt | nc <host> 23\n' "$0" "$0"
+    exit 1
+fi
+
+traceFile="$1"
+clientId="${2:-}"
+
+previousStartMs=""
+while read -r startMs durationUs traceClientId truncated commandLine; do
+    commandLine="${commandLine%$'\r'}"
+    if ! [[ $startMs =~ ^[0-9]+$ ]]; then
+        continue
+    fi
+    if [[ -n $clientId ]] && [[ $traceClientId != "$clientId" ]]; then
+        continue
+    fi
+    if [[ $truncated == T ]]; then
+        >&2 printf 'Skipping truncated command: %s\n' "$commandLine"
+        continue
+    fi
+    if [[ $commandLine =~ ^trace( |$) ]]; then
+        continue
+    fi
+    if [[ -n $previousStartMs ]]; then
+        # The start time is a wrapping 32 bit millisecond counter.
+        delayMs=$(( (startMs - previousStartMs) & 0xffffffff ))
+        sleep "$(printf '%d.%03d' $((delayMs / 1000)) $((delayMs % 1000)))"
+    fi
+    previousStartMs="$startMs"
+    printf '%s\n' "$commandLine"
+done < "$traceFile"
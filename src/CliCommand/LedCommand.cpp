@@ -23,30 +23,43 @@
 #include <Esp32Cli.h>
 #include <LedManager.h>
 
-#define LED_VIEW_FROM_FIRST_ARG m_ledManager->getLedViewByName(argv[1]);\
+#define LED_VIEW_FROM_FIRST_ARG m_ledManager->getLedViewByName(argStr(argv[1]));\
     if (ledView == nullptr) {\
-        io.printf("Unknown LED view '%s'\n", argv[1].c_str());\
+        io.printf("Unknown LED view '%s'\n", argStr(argv[1]));\
         return;\
     }\
     do {} while(0)
 
 
+namespace {
+inline const char* argStr(const std::string& arg) {
+    return arg.c_str();
+}
+
+inline const char* argStr(const char* arg) {
+    return arg;
+}
+}
+
 namespace CliCommand {
 LedCommand::LedCommand(const std::shared_ptr<LedManager>& ledManager)
     : m_ledManager{ledManager} {
 }
 
-std::tuple<float, float, float> LedCommand::parsePosition(std::string positionStr) {
-    ltrim(positionStr, '[');
-    rtrim(positionStr, ']');
-    auto parts = split_str(positionStr, ',');
-    if (parts.size() != 3) {
-        return {0, 0, 0};
-    }
-    return {
-        strtof(parts[0].c_str(), nullptr),
-        strtof(parts[1].c_str(), nullptr),
-        strtof(parts[2].c_str(), nullptr)
+std::tuple<float, float, float> LedCommand::parsePosition(const char* positionStr) {
+    const char* begin = positionStr;
+    const char* end = begin + strlen(positionStr);
+    ltrim(begin, end, '[');
+    rtrim(begin, end, ']');
+    const char* firstComma = find_char(begin, end, ',');
+    const char* secondComma = firstComma == end ? end : find_char(firstComma + 1, end, ',');
+    if (secondComma == end || find_char(secondComma + 1, end, ',') != end) {
+        return std::tuple<float, float, float>{0, 0, 0};
+    }
+    return std::tuple<float, float, float>{
+        parse_float(begin, firstComma),
+        parse_float(firstComma + 1, secondComma),
+        parse_float(secondComma + 1, end)
     };
 }
 
@@ -132,7 +145,7 @@ void SetPosCommand::execute(Stream& io, const std::string& commandName, std::vec
         Esp32Cli::Cli::printUsage(io, commandName, *this);
         return;
     }
-    auto position = parsePosition(argv[1]);
+    auto position = parsePosition(argv[1].c_str());
     float rotation = strtof(argv[2].c_str(), nullptr);
     m_ledManager->setModelLocation({
         std::get<0>(position),
@@ -163,15 +176,43 @@ void SetBrightnessCommand::execute(Stream& io, const std::string& commandName, s
     ledView->addAnimation(std::move(animation));
 }
 
-void SetPixelCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+void MasterBrightnessCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+                                      const std::shared_ptr<Esp32Cli::Client>& client) const {
+    if (argv.size() == 1) {
+        io.println(m_ledManager->getMasterBrightness());
+        return;
+    }
+    if (argv.size() != 2) {
+        Esp32Cli::Cli::printUsage(io, commandName, *this);
+        return;
+    }
+    m_ledManager->setMasterBrightness(strtof(argv[1].c_str(), nullptr));
+}
+
+void ColorCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+                           const std::shared_ptr<Esp32Cli::Client>& client) const {
+    if (argv.size() != 2) {
+        Esp32Cli::Cli::printUsage(io, commandName, *this);
+        return;
+    }
+    auto handle = m_ledManager->getColorManager()->intern(argv[1]);
+    if (handle == Led::ColorManager::InvalidHandle) {
+        io.println(argv[1].c_str());
+        return;
+    }
+    io.print('@');
+    io.println(handle);
+}
+
+void SetPixelCommand::execute(Stream& io, const Esp32Cli::ArgvView& argv,
                               const std::shared_ptr<Esp32Cli::Client>& client) const {
     if (argv.size() != 4) {
-        Esp32Cli::Cli::printUsage(io, commandName, *this);
+        Esp32Cli::Cli::printUsage(io, argv, *this);
         return;
     }
     auto ledView = LED_VIEW_FROM_FIRST_ARG;
-    Led::Led::index_t ledIndex = strtoul(argv[2].c_str(), nullptr, 0);
-    const std::string& ledColor = argv[3];
+    Led::Led::index_t ledIndex = strtoul(argv[2], nullptr, 0);
+    const char* ledColor = argv[3];
     std::unique_ptr<AnimationConfig> animation{
         new AnimationConfig{
             ledColor,
@@ -182,17 +223,17 @@ void SetPixelCommand::execute(Stream& io, const std::string& commandName, std::v
     ledView->addAnimation(std::move(animation));
 }
 
-void AnimatePixelCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+void AnimatePixelCommand::execute(Stream& io, const Esp32Cli::ArgvView& argv,
                                   const std::shared_ptr<Esp32Cli::Client>& client) const {
     if (argv.size() != 6) {
-        Esp32Cli::Cli::printUsage(io, commandName, *this);
+        Esp32Cli::Cli::printUsage(io, argv, *this);
         return;
     }
     auto ledView = LED_VIEW_FROM_FIRST_ARG;
-    Led::Led::index_t ledIndex = strtoul(argv[2].c_str(), nullptr, 0);
+    Led::Led::index_t ledIndex = strtoul(argv[2], nullptr, 0);
     auto delay = Led::Animation::parseDuration(argv[3]).eval(1);
     auto duration = Led::Animation::parseDuration(argv[4]);
-    const std::string& ledColor = argv[5];
+    const char* ledColor = argv[5];
     std::unique_ptr<AnimationConfig> animation{
         new AnimationConfig{
             ledColor,
@@ -205,17 +246,17 @@ void AnimatePixelCommand::execute(Stream& io, const std::string& commandName, st
     ledView->addAnimation(std::move(animation));
 }
 
-void AnimateCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+void AnimateCommand::execute(Stream& io, const Esp32Cli::ArgvView& argv,
                              const std::shared_ptr<Esp32Cli::Client>& client) const {
-    if (argv.size() != 6 && argv.size() != 9) {
-        Esp32Cli::Cli::printUsage(io, commandName, *this);
+    if (argv.size() != 6 && argv.size() != 9 && argv.size() != 10) {
+        Esp32Cli::Cli::printUsage(io, argv, *this);
         return;
     }
     auto ledView = LED_VIEW_FROM_FIRST_ARG;
     auto delay = Led::Animation::parseDuration(argv[2]).eval(1);
     auto ledDelay = Led::Animation::parseDuration(argv[3]);
     auto duration = Led::Animation::parseDuration(argv[4]);
-    const std::string& ledColor = argv[5];
+    const char* ledColor = argv[5];
 
     std::unique_ptr<AnimationConfig> animation{
         new AnimationConfig{
@@ -225,13 +266,13 @@ void AnimateCommand::execute(Stream& io, const std::string& commandName, std::ve
     animation->startDelay = delay;
     animation->ledDelay = ledDelay;
     animation->ledDuration = duration;
-    if (argv.size() == 9) {
-        int8_t halfCycles = static_cast<int8_t>(strtol(argv[6].c_str(), nullptr, 0));
-        const std::string& blendFunc = argv[7];
-        const std::string& easeFunc = argv[8];
+    if (argv.size() >= 9) {
+        int8_t halfCycles = static_cast<int8_t>(strtol(argv[6], nullptr, 0));
+        const char* blendFunc = argv[7];
+        const char* easeFunc = argv[8];
 
         Led::Blending blending = Led::Blending::Blend;
-        if (blendFunc == "add") {
+        if (strcmp(blendFunc, "add") == 0) {
             blending = Led::Blending::Add;
         }
 
@@ -239,14 +280,21 @@ void AnimateCommand::execute(Stream& io, const std::string& commandName, std::ve
         animation->easing = Easing::getFuncByName(easeFunc);
         animation->halfCycles = halfCycles;
     }
+    if (argv.size() == 10) {
+        animation->layer = Led::layerFromName(argv[9]);
+        if (animation->layer == Led::Layer::Invalid) {
+            Esp32Cli::Cli::printUsage(io, argv, *this);
+            return;
+        }
+    }
 
     ledView->addAnimation(std::move(animation));
 }
 
-void Animate3DCommand::execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv,
+void Animate3DCommand::execute(Stream& io, const Esp32Cli::ArgvView& argv,
                                const std::shared_ptr<Esp32Cli::Client>& client) const {
-    if (argv.size() != 9 && argv.size() != 12) {
-        Esp32Cli::Cli::printUsage(io, commandName, *this);
+    if (argv.size() != 9 && argv.size() != 12 && argv.size() != 13) {
+        Esp32Cli::Cli::printUsage(io, argv, *this);
         return;
     }
 
@@ -255,13 +303,13 @@ void Animate3DCommand::execute(Stream& io, const std::string& commandName, std::
      */
 
     auto ledView = LED_VIEW_FROM_FIRST_ARG;
-    bool positionIsLocal = argv[2] == "local";
+    bool positionIsLocal = argv.equals(2, "local");
     auto position = parsePosition(argv[3]);
     auto delay = Led::Animation::parseDuration(argv[4]).eval(1);
     auto ledDelay = Led::Animation::parseDuration(argv[5]);
     auto duration = Led::Animation::parseDuration(argv[6]);
-    float range = strtof(argv[7].c_str(), nullptr);
-    const std::string& ledColor = argv[8];
+    float range = strtof(argv[7], nullptr);
+    const char* ledColor = argv[8];
 
     std::unique_ptr<AnimationConfig> animation{
         new AnimationConfig{
@@ -278,13 +326,13 @@ void Animate3DCommand::execute(Stream& io, const std::string& commandName, std::
     }
     animation->range = range;
 
-    if (argv.size() == 12) {
-        int8_t halfCycles = static_cast<int8_t>(strtol(argv[9].c_str(), nullptr, 0));
-        const std::string& blendFunc = argv[10];
-        const std::string& easeFunc = argv[11];
+    if (argv.size() >= 12) {
+        int8_t halfCycles = static_cast<int8_t>(strtol(argv[9], nullptr, 0));
+        const char* blendFunc = argv[10];
+        const char* easeFunc = argv[11];
 
         Led::Blending blending = Led::Blending::Blend;
-        if (blendFunc == "add") {
+        if (strcmp(blendFunc, "add") == 0) {
             blending = Led::Blending::Add;
         }
 
@@ -292,6 +340,106 @@ void Animate3DCommand::execute(Stream& io, const std::string& commandName, std::
         animation->easing = Easing::getFuncByName(easeFunc);
         animation->halfCycles = halfCycles;
     }
+    if (argv.size() == 13) {
+        animation->layer = Led::layerFromName(argv[12]);
+        if (animation->layer == Led::Layer::Invalid) {
+            Esp32Cli::Cli::printUsage(io, argv, *this);
+            return;
+        }
+    }
+
+    ledView->addAnimation(std::move(animation));
+}
+
+namespace {
+struct __attribute__((packed)) BinaryAnimation {
+    uint16_t viewId;
+    uint8_t flags;
+    uint8_t easing;
+    uint8_t blending;
+    uint8_t layer;
+    int8_t halfCycles;
+    uint8_t reserved;
+    uint16_t startDelay;
+    uint16_t ledDelayMin;
+    uint16_t ledDelayMax;
+    uint16_t ledDurationMin;
+    uint16_t ledDurationMax;
+    float x;
+    float y;
+    float z;
+    float range;
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+    uint8_t w;
+    uint8_t brightness;
+};
+
+static_assert(sizeof(BinaryAnimation) == 42, "Binary animation layout changed");
+}
+
+void AnimateBinaryCommand::execute(Stream& io, const uint8_t* payload, size_t size,
+                                   const std::shared_ptr<Esp32Cli::Client>& client) const {
+    using Duration = Led::Animation::duration;
+
+    if (size != sizeof(BinaryAnimation)) {
+        io.printf("animate: invalid binary frame size %u\n", static_cast<unsigned>(size));
+        return;
+    }
+    BinaryAnimation frame;
+    memcpy(&frame, payload, sizeof(frame));
+
+    auto ledView = m_ledManager->getLedViewById(frame.viewId);
+    if (ledView == nullptr) {
+        io.printf("Unknown LED view %u\n", frame.viewId);
+        return;
+    }
+
+    const auto layer = static_cast<Led::Layer>(frame.layer);
+    if (layer != Led::Layer::Auto && frame.layer >= Led::LayerCount) {
+        io.printf("animate: invalid layer %u\n", frame.layer);
+        return;
+    }
+
+    Led::HslwColor color{0.f};
+    if (frame.flags & ColorHandle) {
+        color = m_ledManager->getColorManager()->resolve(frame.r, ledView->getPrimaryColor());
+    } else {
+        color = Led::HslwColor{Rgb48Color{frame.r, frame.g, frame.b}, frame.w, frame.brightness / 255.f};
+    }
+
+    std::unique_ptr<LedView::AnimationConfig> animation{
+        new LedView::AnimationConfig{color}
+    };
+    const uint16_t ledDelayMin = frame.ledDelayMin;
+    const uint16_t ledDurationMin = frame.ledDurationMin;
+    animation->startDelay = Duration{frame.startDelay};
+    animation->ledDelay = {
+        Duration{ledDelayMin}, Duration{std::max(ledDelayMin, static_cast<uint16_t>(frame.ledDelayMax))},
+        !(frame.flags & LedDelayIsTotal), (frame.flags & LedDelayIsGlobal) != 0
+    };
+    animation->ledDuration = {
+        Duration{ledDurationMin}, Duration{std::max(ledDurationMin, static_cast<uint16_t>(frame.ledDurationMax))},
+        !(frame.flags & LedDurationIsTotal), false
+    };
+    if (frame.easing < easeFunctions.size()) {
+        animation->easing = easeFunctions[frame.easing];
+    }
+    animation->blending = frame.blending == 1 ? Led::Blending::Add : Led::Blending::Blend;
+    animation->layer = layer;
+    animation->halfCycles = frame.halfCycles;
+    if (frame.flags & Wave3D) {
+        animation->animationType = LedView::AnimationType::Wave3D;
+        const float x = frame.x;
+        const float y = frame.y;
+        const float z = frame.z;
+        animation->startPos = std::make_tuple(x, y, z);
+        animation->range = frame.range;
+        if (frame.flags & GlobalPosition) {
+            animation->modelLocation = m_ledManager->getModelLocation();
+        }
+    }
 
     ledView->addAnimation(std::move(animation));
 }
@@ -334,8 +482,8 @@ void StartupAnimationCommand::execute(Stream& io, const std::string& commandName
         m_ledManager->stopAllAnimations();
         bool isManualControl = m_ledManager->isManualMode();
         m_ledManager->setManualMode(true);
-        argv = {"animate", "All", "0", "0", "1", "rgb(0,0,0)"};
-        AnimateCommand{m_ledManager}.execute(io, "animate", argv, client);
+        const char* animateArgv[] = {"animate", "All", "0", "0", "1", "rgb(0,0,0)", nullptr};
+        AnimateCommand{m_ledManager}.execute(io, Esp32Cli::ArgvView{animateArgv, 6}, client);
         m_js->runScript("import {main} from '/data/bin/main.js'; main()", io);
         m_ledManager->setManualMode(isManualControl);
         return;
@@ -356,6 +504,8 @@ LedCommandGroup::LedCommandGroup(const std::shared_ptr<LedManager>& ledManager,
     addCommand<GetPosCommand>("get-pos", ledManager);
     addCommand<SetPosCommand>("set-pos", ledManager);
     addCommand<SetBrightnessCommand>("set-brightness", ledManager);
+    addCommand<MasterBrightnessCommand>("master-brightness", ledManager);
+    addCommand<ColorCommand>("color", ledManager);
     addCommand<SetPixelCommand>("set-pixel", ledManager);
     addCommand<AnimatePixelCommand>("animate-pixel", ledManager);
     addCommand<AnimateCommand>("animate", ledManager);
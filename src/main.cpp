@@ -65,7 +65,9 @@ public:
             return;
         }
         size_t size = strtol(argv[1].c_str(), nullptr, 0);
+        const size_t totalSize = size;
         io.printf("Sending %i bytes\n", size);
+        const auto start = millis();
         while (size > 0) {
             size_t writeSize = io.write(buf, std::min(size, 8u));
             size -= writeSize;
@@ -75,6 +77,10 @@ public:
             }
         }
         io.println();
+        // Time until the data was handed to the client, buffered output of the last bytes might still be in flight.
+        const auto duration = std::max(millis() - start, 1ul);
+        io.printf("Sent %i bytes in %lu ms (%lu bytes/s)\n", totalSize, duration,
+                  static_cast<unsigned long>(totalSize * 1000ull / duration));
     }
 };
 
@@ -185,7 +191,8 @@ void setup() {
     wifiManager = std::make_shared<ArduinoMultiWiFi>(
         std::unique_ptr<WiFiCredentialSource>(new WiFiCredentialSource), preferences
     );
-    telnetServer = std::make_shared<Esp32Cli::TelnetServer>(espCli, 23);
+    telnetServer = std::make_shared<Esp32Cli::TelnetServer>(cli, 23);
+    cli->addCommand<Esp32Cli::TelnetCommand>("telnet", telnetServer);
 #endif
 
     bleUi = std::make_shared<Esp32BleUi>(cli);
@@ -207,13 +214,17 @@ void setup() {
     colorManager->loadColorsFromConfig("/data/lib/colors.json");
     ledManager = std::make_shared<LedManager>(keyValueStore, colorManager, js);
     ledManager->loadLedsFromConfig("/data/etc/leds.json");
+    bleUi->addAdvertisedValue("Settings/ManualMode");
+    bleUi->addAdvertisedValue("Settings/MasterBright");
     cli->addCommand<CliCommand::LedCommandGroup>("led", ledManager, js);
+    cli->addBinaryCommand<CliCommand::AnimateBinaryCommand>(CliCommand::AnimateBinaryCommand::Type, ledManager);
 
     cli->addCommand<MetricsCommand>("metrics");
     cli->addCommand<TestDataCommand>("test-data");
     cli->addCommand<TestUploadCommand>("test-upload");
     cli->addCommand<CrashCommand>("crash");
     cli->addCommand<ThermalCommand>("thermal");
+    cli->freeze();
 
     if (ledManager->isStartupAnimationEnabled()) {
         std::vector<std::string> argv = {"led", "startup-animation"};
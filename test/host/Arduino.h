@@ -0,0 +1,312 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Minimal host replacement of the Arduino-ESP32 core for the native test environment. Only covers what the libraries
+ * under test use, output goes to stdout.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+
+#define ARDUINO_RUNNING_CORE 1
+
+#define log_e(format, ...) fprintf(stderr, "[E] " format "\n", ##__VA_ARGS__)
+#define log_w(format, ...) fprintf(stderr, "[W] " format "\n", ##__VA_ARGS__)
+#define log_i(format, ...) do {} while (0)
+#define log_d(format, ...) do {} while (0)
+#define log_v(format, ...) do {} while (0)
+
+inline unsigned long millis() {
+    static const auto start = std::chrono::steady_clock::now();
+    return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+inline unsigned long micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+inline void delay(const uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline uint32_t esp_random() {
+    return static_cast<uint32_t>(rand());
+}
+
+/**
+ * Only what the libraries use of the Arduino String: Construction and concatenation.
+ */
+class String {
+public:
+    String(const char* str = "") : m_str{str} {
+    }
+
+    String(std::string str) : m_str{std::move(str)} {
+    }
+
+    const char* c_str() const {
+        return m_str.c_str();
+    }
+
+    friend String operator+(const String& left, const String& right) {
+        return String{left.m_str + right.m_str};
+    }
+
+    friend String operator+(const char* left, const String& right) {
+        return String{left + right.m_str};
+    }
+
+    friend String operator+(const String& left, const char* right) {
+        return String{left.m_str + right};
+    }
+
+private:
+    std::string m_str;
+};
+
+class Print {
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t written = 0;
+        while (size--) {
+            written += write(*buffer++);
+        }
+        return written;
+    }
+
+    size_t write(const char* str) {
+        return str == nullptr ? 0 : write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+    }
+
+    size_t write(const char* buffer, size_t size) {
+        return write(reinterpret_cast<const uint8_t*>(buffer), size);
+    }
+
+    virtual int availableForWrite() {
+        return 0;
+    }
+
+    virtual void flush() {
+    }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        const int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (length < 0) {
+            return 0;
+        }
+        if (static_cast<size_t>(length) < sizeof(buffer)) {
+            return write(buffer, length);
+        }
+        std::string longBuffer(length + 1, '\0');
+        va_start(args, format);
+        vsnprintf(&longBuffer[0], longBuffer.size(), format, args);
+        va_end(args);
+        return write(longBuffer.data(), length);
+    }
+
+    size_t print(const char* str) {
+        return write(str);
+    }
+
+    size_t print(const std::string& str) {
+        return write(str.data(), str.size());
+    }
+
+    size_t print(char c) {
+        return write(static_cast<uint8_t>(c));
+    }
+
+    size_t print(long long n) {
+        return printf("%lld", n);
+    }
+
+    size_t print(unsigned long long n) {
+        return printf("%llu", n);
+    }
+
+    size_t print(int n) {
+        return print(static_cast<long long>(n));
+    }
+
+    size_t print(unsigned n) {
+        return print(static_cast<unsigned long long>(n));
+    }
+
+    size_t print(long n) {
+        return print(static_cast<long long>(n));
+    }
+
+    size_t print(unsigned long n) {
+        return print(static_cast<unsigned long long>(n));
+    }
+
+    size_t print(double n, int digits = 2) {
+        return printf("%.*f", digits, n);
+    }
+
+    size_t println() {
+        return write("\r\n");
+    }
+
+    template<typename T>
+    size_t println(const T& value) {
+        const size_t written = print(value);
+        return written + println();
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+
+    virtual int read() = 0;
+
+    virtual int peek() = 0;
+
+    void setTimeout(const unsigned long timeout) {
+        m_timeout = timeout;
+    }
+
+    virtual size_t readBytes(char* buffer, size_t length) {
+        size_t count = 0;
+        while (count < length) {
+            const int c = timedRead();
+            if (c < 0) {
+                break;
+            }
+            buffer[count++] = static_cast<char>(c);
+        }
+        return count;
+    }
+
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        return readBytes(reinterpret_cast<char*>(buffer), length);
+    }
+
+protected:
+    int timedRead() {
+        const unsigned long start = millis();
+        do {
+            const int c = read();
+            if (c >= 0) {
+                return c;
+            }
+            std::this_thread::yield();
+        } while (millis() - start < m_timeout);
+        return -1;
+    }
+
+    unsigned long m_timeout{1000};
+};
+
+class Client : public Stream {
+public:
+    virtual int connect(const char* host, uint16_t port) = 0;
+
+    virtual uint8_t connected() = 0;
+
+    virtual void stop() = 0;
+
+    using Print::write;
+};
+
+class HardwareSerial : public Stream {
+public:
+    size_t write(const uint8_t c) override {
+        return fwrite(&c, 1, 1, stdout);
+    }
+
+    size_t write(const uint8_t* buffer, const size_t size) override {
+        return fwrite(buffer, 1, size, stdout);
+    }
+
+    int available() override {
+        return 0;
+    }
+
+    int read() override {
+        return -1;
+    }
+
+    int peek() override {
+        return -1;
+    }
+
+    using Print::write;
+};
+
+static HardwareSerial Serial;
+
+struct EspClass {
+    [[noreturn]] void restart() {
+        fprintf(stderr, "ESP.restart()\n");
+        abort();
+    }
+
+    uint32_t getFreeHeap() {
+        return 0;
+    }
+};
+
+static EspClass ESP;
+
+#define MALLOC_CAP_DEFAULT 0
+
+struct multi_heap_info_t {
+    size_t total_free_bytes;
+    size_t total_allocated_bytes;
+    size_t largest_free_block;
+    size_t minimum_free_bytes;
+    size_t allocated_blocks;
+    size_t free_blocks;
+    size_t total_blocks;
+};
+
+inline void heap_caps_get_info(multi_heap_info_t* info, uint32_t) {
+    *info = multi_heap_info_t{};
+}
@@ -0,0 +1,37 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Host build of the Esp32Cli sources. Include from exactly one source file of a test suite, the native environment
+ * does not build the libraries itself.
+ */
+
+#pragma once
+
+#include "../../lib/Esp32Cli/src/Esp32Cli.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/Client.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/Command.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/CommandGroup.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/CommandTrace.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/CommonCommands.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/DispatchTable.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/Executor.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/FramedStream.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/Telnet.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/TelnetAwareClient.cpp"
+#include "../../lib/Esp32Cli/src/Esp32Cli/TelnetServer.cpp"
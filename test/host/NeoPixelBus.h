@@ -0,0 +1,172 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Host replacement of the NeoPixelBus color types used by the LED library. Follows the NeoPixelBus conversions, so
+ * results match the device, but the pixel buses themselves are not available.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+struct HslColor;
+struct Rgb48Color;
+
+struct RgbColor {
+    RgbColor(uint8_t r = 0, uint8_t g = 0, uint8_t b = 0) : R{r}, G{g}, B{b} {
+    }
+
+    RgbColor(const HslColor& color);
+
+    uint8_t R;
+    uint8_t G;
+    uint8_t B;
+};
+
+struct Rgb48Color {
+    Rgb48Color(uint16_t r = 0, uint16_t g = 0, uint16_t b = 0) : R{r}, G{g}, B{b} {
+    }
+
+    uint16_t R;
+    uint16_t G;
+    uint16_t B;
+};
+
+struct HslColor {
+    HslColor(float h = 0, float s = 0, float l = 0) : H{h}, S{s}, L{l} {
+    }
+
+    HslColor(const Rgb48Color& color) {
+        const float r = static_cast<float>(color.R) / 65535.0f;
+        const float g = static_cast<float>(color.G) / 65535.0f;
+        const float b = static_cast<float>(color.B) / 65535.0f;
+        const float max = std::max(r, std::max(g, b));
+        const float min = std::min(r, std::min(g, b));
+        L = (max + min) / 2.0f;
+        if (max == min) {
+            H = 0;
+            S = 0;
+            return;
+        }
+        const float d = max - min;
+        S = L > 0.5f ? d / (2.0f - max - min) : d / (max + min);
+        if (r == max) {
+            H = (g - b) / d + (g < b ? 6.0f : 0.0f);
+        } else if (g == max) {
+            H = (b - r) / d + 2.0f;
+        } else {
+            H = (r - g) / d + 4.0f;
+        }
+        H /= 6.0f;
+    }
+
+    float H;
+    float S;
+    float L;
+};
+
+inline float hostCalcHslChannel(float p, float q, float t) {
+    if (t < 0.0f) {
+        t += 1.0f;
+    }
+    if (t > 1.0f) {
+        t -= 1.0f;
+    }
+    if (t < 1.0f / 6.0f) {
+        return p + (q - p) * 6.0f * t;
+    }
+    if (t < 0.5f) {
+        return q;
+    }
+    if (t < 2.0f / 3.0f) {
+        return p + ((q - p) * (2.0f / 3.0f - t) * 6.0f);
+    }
+    return p;
+}
+
+inline RgbColor::RgbColor(const HslColor& color) {
+    float r;
+    float g;
+    float b;
+    if (color.S == 0.0f || color.L == 0.0f) {
+        r = g = b = color.L;
+    } else {
+        const float q = color.L < 0.5f ? color.L * (1.0f + color.S) : color.L + color.S - (color.L * color.S);
+        const float p = 2.0f * color.L - q;
+        r = hostCalcHslChannel(p, q, color.H + 1.0f / 3.0f);
+        g = hostCalcHslChannel(p, q, color.H);
+        b = hostCalcHslChannel(p, q, color.H - 1.0f / 3.0f);
+    }
+    R = static_cast<uint8_t>(r * 255.0f);
+    G = static_cast<uint8_t>(g * 255.0f);
+    B = static_cast<uint8_t>(b * 255.0f);
+}
+
+struct RgbwColor {
+    RgbwColor(uint8_t r = 0, uint8_t g = 0, uint8_t b = 0, uint8_t w = 0) : R{r}, G{g}, B{b}, W{w} {
+    }
+
+    RgbwColor(const RgbColor& color) : R{color.R}, G{color.G}, B{color.B}, W{0} {
+    }
+
+    RgbwColor(const HslColor& color) : RgbwColor{RgbColor{color}} {
+    }
+
+    bool operator==(const RgbwColor& other) const {
+        return R == other.R && G == other.G && B == other.B && W == other.W;
+    }
+
+    bool operator!=(const RgbwColor& other) const {
+        return !(*this == other);
+    }
+
+    RgbwColor Dim(uint8_t ratio) const {
+        return {dimElement(R, ratio), dimElement(G, ratio), dimElement(B, ratio), dimElement(W, ratio)};
+    }
+
+    RgbwColor Brighten(uint8_t ratio) const {
+        return {brightenElement(R, ratio), brightenElement(G, ratio), brightenElement(B, ratio),
+                brightenElement(W, ratio)};
+    }
+
+    static RgbwColor LinearBlend(const RgbwColor& left, const RgbwColor& right, float progress) {
+        return {
+            static_cast<uint8_t>(left.R + ((right.R - left.R) * progress)),
+            static_cast<uint8_t>(left.G + ((right.G - left.G) * progress)),
+            static_cast<uint8_t>(left.B + ((right.B - left.B) * progress)),
+            static_cast<uint8_t>(left.W + ((right.W - left.W) * progress))
+        };
+    }
+
+    uint8_t R;
+    uint8_t G;
+    uint8_t B;
+    uint8_t W;
+
+private:
+    static uint8_t dimElement(uint8_t value, uint8_t ratio) {
+        return static_cast<uint8_t>((static_cast<uint16_t>(value) * (static_cast<uint16_t>(ratio) + 1)) >> 8);
+    }
+
+    static uint8_t brightenElement(uint8_t value, uint8_t ratio) {
+        uint16_t element = static_cast<uint16_t>((static_cast<uint16_t>(value) + 1) << 8);
+        element /= static_cast<uint16_t>(ratio) + 1;
+        return element > 255 ? 255 : static_cast<uint8_t>(element - 1);
+    }
+};
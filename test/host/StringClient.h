@@ -0,0 +1,87 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Esp32Cli/Client.h>
+
+#include <string>
+
+/**
+ * Client reading its input from a string and collecting all output, commands run on the calling thread.
+ */
+class StringClient : public Esp32Cli::Client {
+public:
+    explicit StringClient(std::shared_ptr<Esp32Cli::Cli> cli) : Client{std::move(cli)} {
+    }
+
+    /**
+     * Parse and execute the input, the output is appended to @link output.
+     */
+    void execute(const std::string& input) {
+        m_input = input;
+        m_inputPosition = 0;
+        executeCommandLine(ExecType::NonBlocking);
+    }
+
+    int available() override {
+        return static_cast<int>(m_input.size() - m_inputPosition);
+    }
+
+    int read() override {
+        if (m_inputPosition == m_input.size()) {
+            return -1;
+        }
+        return static_cast<uint8_t>(m_input[m_inputPosition++]);
+    }
+
+    int peek() override {
+        if (m_inputPosition == m_input.size()) {
+            return -1;
+        }
+        return static_cast<uint8_t>(m_input[m_inputPosition]);
+    }
+
+    size_t write(const uint8_t c) override {
+        output.push_back(static_cast<char>(c));
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, const size_t size) override {
+        output.append(reinterpret_cast<const char*>(buffer), size);
+        return size;
+    }
+
+    using Print::write;
+
+    std::string output;
+
+protected:
+    size_t borrowInput(const char** data, const ExecType execType) override {
+        *data = m_input.data() + m_inputPosition;
+        return m_input.size() - m_inputPosition;
+    }
+
+    void consumeInput(const size_t size) override {
+        m_inputPosition += size;
+    }
+
+private:
+    std::string m_input;
+    size_t m_inputPosition{0};
+};
@@ -0,0 +1,179 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Host replacement of the Arduino-ESP32 WiFi client over a system socket, so the telnet code can be tested against
+ * local sockets. The station itself is not emulated, the local IP is the loopback address.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <lwip/sockets.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+class WiFiClient : public Client {
+public:
+    WiFiClient() = default;
+
+    explicit WiFiClient(const int fd) : m_fd{fd}, m_isConnected{fd >= 0} {
+    }
+
+    ~WiFiClient() override {
+        stop();
+    }
+
+    int connect(const char* host, const uint16_t port) override {
+        stop();
+        m_fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (m_fd < 0 || inet_pton(AF_INET, host, &address.sin_addr) != 1 ||
+            ::connect(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            stop();
+            return 0;
+        }
+        m_isConnected = true;
+        return 1;
+    }
+
+    uint8_t connected() override {
+        if (m_isConnected) {
+            uint8_t value;
+            const ssize_t result = recv(m_fd, &value, 1, MSG_PEEK | MSG_DONTWAIT);
+            m_isConnected = result > 0 || (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        }
+        return m_isConnected;
+    }
+
+    void stop() override {
+        if (m_fd >= 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+        m_isConnected = false;
+    }
+
+    size_t write(const uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* buffer, const size_t size) override {
+        size_t written = 0;
+        while (m_isConnected && written < size) {
+            const ssize_t result = send(m_fd, buffer + written, size - written, MSG_NOSIGNAL);
+            if (result <= 0) {
+                stop();
+                break;
+            }
+            written += static_cast<size_t>(result);
+        }
+        return written;
+    }
+
+    int available() override {
+        int count = 0;
+        if (!m_isConnected || ioctl(m_fd, FIONREAD, &count) != 0) {
+            return 0;
+        }
+        return count;
+    }
+
+    int read() override {
+        uint8_t value;
+        return read(&value, 1) == 1 ? value : -1;
+    }
+
+    int read(uint8_t* buffer, const size_t size) {
+        if (!m_isConnected) {
+            return -1;
+        }
+        const ssize_t result = recv(m_fd, buffer, size, MSG_DONTWAIT);
+        if (result == 0) {
+            m_isConnected = false;
+        }
+        return result > 0 ? static_cast<int>(result) : -1;
+    }
+
+    int peek() override {
+        uint8_t value;
+        if (!m_isConnected || recv(m_fd, &value, 1, MSG_PEEK | MSG_DONTWAIT) != 1) {
+            return -1;
+        }
+        return value;
+    }
+
+    /**
+     * Waits up to the timeout for data like the Stream implementation, but returns once the connection is closed.
+     */
+    size_t readBytes(char* buffer, const size_t length) override {
+        size_t count = 0;
+        const unsigned long start = millis();
+        while (count < length && connected()) {
+            const int result = read(reinterpret_cast<uint8_t*>(buffer) + count, length - count);
+            if (result > 0) {
+                count += static_cast<size_t>(result);
+                continue;
+            }
+            const unsigned long waitedMs = millis() - start;
+            if (waitedMs >= m_timeout) {
+                break;
+            }
+            pollfd readable{m_fd, POLLIN, 0};
+            poll(&readable, 1, static_cast<int>(std::min<unsigned long>(m_timeout - waitedMs, 100)));
+        }
+        return count;
+    }
+
+    using Client::readBytes;
+    using Client::write;
+
+    int fd() const {
+        return m_fd;
+    }
+
+    void setNoDelay(const bool noDelay) {
+        int enable = noDelay;
+        setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+
+    explicit operator bool() {
+        return connected();
+    }
+
+private:
+    int m_fd{-1};
+    bool m_isConnected{false};
+};
+
+struct IPAddress {
+    operator std::string() const {
+        return "127.0.0.1";
+    }
+};
+
+struct WiFiClass {
+    IPAddress localIP() {
+        return {};
+    }
+};
+
+static WiFiClass WiFi;
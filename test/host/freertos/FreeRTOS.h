@@ -0,0 +1,214 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Host replacement of the FreeRTOS task, queue and timer API based on std::thread for the native test environment.
+ * Tasks deleted via vTaskDelete unwind their thread with an exception, so a task may only be deleted while it waits
+ * on a queue, in select() (see lwip/sockets.h) or by itself.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+
+struct HostTask {
+    std::thread thread;
+    bool isDeleted{false};
+};
+
+typedef HostTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+struct HostTaskDeleted {
+};
+
+struct HostQueue {
+    size_t itemSize;
+    size_t length;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+typedef HostQueue* QueueHandle_t;
+
+/**
+ * All queues share one mutex and condition variable, deleting a task has to wake it wherever it waits.
+ */
+struct HostScheduler {
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    static HostScheduler& instance() {
+        static HostScheduler scheduler;
+        return scheduler;
+    }
+
+    static HostTask*& currentTask() {
+        static thread_local HostTask* task = nullptr;
+        return task;
+    }
+
+    /**
+     * Wait until the predicate is true or the timeout expired. Unwinds the calling task if it was deleted meanwhile.
+     */
+    template<typename Predicate>
+    bool wait(std::unique_lock<std::mutex>& lock, const TickType_t ticks, Predicate predicate) {
+        HostTask* task = currentTask();
+        auto isDone = [&] {
+            return (task != nullptr && task->isDeleted) || predicate();
+        };
+        bool result;
+        if (ticks == portMAX_DELAY) {
+            changed.wait(lock, isDone);
+            result = true;
+        } else {
+            result = changed.wait_for(lock, std::chrono::milliseconds(ticks), isDone);
+        }
+        if (task != nullptr && task->isDeleted) {
+            throw HostTaskDeleted{};
+        }
+        return result && predicate();
+    }
+};
+
+inline BaseType_t xTaskCreatePinnedToCore(const TaskFunction_t function, const char*, uint32_t, void* parameter,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    auto task = new HostTask;
+    {
+        // Hold the lock so the handle is stored before the task runs.
+        std::unique_lock<std::mutex> lock{HostScheduler::instance().mutex};
+        task->thread = std::thread{[task, function, parameter] {
+            {
+                std::unique_lock<std::mutex> startLock{HostScheduler::instance().mutex};
+                HostScheduler::currentTask() = task;
+            }
+            try {
+                function(parameter);
+            } catch (const HostTaskDeleted&) {
+            }
+        }};
+        if (handle != nullptr) {
+            *handle = task;
+        }
+    }
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(const TaskFunction_t function, const char* name, const uint32_t stackSize,
+                              void* parameter, const UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(function, name, stackSize, parameter, priority, handle, 0);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return HostScheduler::currentTask();
+}
+
+inline void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == HostScheduler::currentTask()) {
+        task = HostScheduler::currentTask();
+        task->thread.detach();
+        delete task;
+        HostScheduler::currentTask() = nullptr;
+        throw HostTaskDeleted{};
+    }
+    {
+        std::unique_lock<std::mutex> lock{HostScheduler::instance().mutex};
+        task->isDeleted = true;
+    }
+    HostScheduler::instance().changed.notify_all();
+    task->thread.join();
+    delete task;
+}
+
+inline void vTaskDelay(const TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t itemSize) {
+    return new HostQueue{itemSize, length, {}};
+}
+
+inline void vQueueDelete(const QueueHandle_t queue) {
+    delete queue;
+}
+
+inline BaseType_t xQueueSend(const QueueHandle_t queue, const void* item, const TickType_t ticks) {
+    auto& scheduler = HostScheduler::instance();
+    {
+        std::unique_lock<std::mutex> lock{scheduler.mutex};
+        if (!scheduler.wait(lock, ticks, [queue] { return queue->items.size() < queue->length; })) {
+            return pdFALSE;
+        }
+        const auto bytes = static_cast<const uint8_t*>(item);
+        queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    }
+    scheduler.changed.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(const QueueHandle_t queue, void* item, const TickType_t ticks) {
+    auto& scheduler = HostScheduler::instance();
+    {
+        std::unique_lock<std::mutex> lock{scheduler.mutex};
+        if (!scheduler.wait(lock, ticks, [queue] { return !queue->items.empty(); })) {
+            return pdFALSE;
+        }
+        memcpy(item, queue->items.front().data(), queue->itemSize);
+        queue->items.pop_front();
+    }
+    scheduler.changed.notify_all();
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t queue) {
+    std::unique_lock<std::mutex> lock{HostScheduler::instance().mutex};
+    return queue->items.size();
+}
+
+typedef void* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+
+/**
+ * Timers are not run on the host, only the reset command uses one.
+ */
+inline TimerHandle_t xTimerCreate(const char*, TickType_t, UBaseType_t, void*, TimerCallbackFunction_t) {
+    return nullptr;
+}
+
+inline BaseType_t xTimerStart(TimerHandle_t, TickType_t) {
+    return pdPASS;
+}
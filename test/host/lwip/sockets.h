@@ -0,0 +1,48 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// lwIP provides the BSD socket API on the device, the host uses the system sockets.
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+
+/**
+ * Like lwIP, route select() through its own function. It unwinds a task that was deleted while it waited, so tasks
+ * looping on select() can be deleted.
+ */
+inline int lwip_select(const int maxFd, fd_set* readSet, fd_set* writeSet, fd_set* exceptSet, timeval* timeout) {
+    const int result = ::select(maxFd, readSet, writeSet, exceptSet, timeout);
+    HostTask* task = HostScheduler::currentTask();
+    if (task != nullptr) {
+        std::unique_lock<std::mutex> lock{HostScheduler::instance().mutex};
+        if (task->isDeleted) {
+            throw HostTaskDeleted{};
+        }
+    }
+    return result;
+}
+
+#define select(maxfdp1, readset, writeset, exceptset, timeout) lwip_select(maxfdp1, readset, writeset, exceptset, timeout)
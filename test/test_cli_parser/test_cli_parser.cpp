@@ -0,0 +1,183 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Esp32Cli.h>
+#include <StringClient.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unity.h>
+
+namespace {
+/**
+ * Prints its arguments separated by '|'.
+ */
+class EchoCommand : public Esp32Cli::ArgvCommand {
+public:
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        for (size_t i = 1; i < argv.size(); i++) {
+            if (i > 1) {
+                io.print('|');
+            }
+            io.print(argv[i]);
+        }
+        io.print('\n');
+    }
+};
+
+/**
+ * Counts the executed commands and their arguments without printing.
+ */
+class CountCommand : public Esp32Cli::ArgvCommand {
+public:
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        commandCount++;
+        argumentCount += argv.size() - 1;
+    }
+
+    static size_t commandCount;
+    static size_t argumentCount;
+};
+
+size_t CountCommand::commandCount = 0;
+size_t CountCommand::argumentCount = 0;
+
+/**
+ * Uses the default single byte input of @link Esp32Cli::Client like clients without a buffer of their own.
+ */
+class ByteStringClient : public StringClient {
+public:
+    using StringClient::StringClient;
+
+protected:
+    size_t borrowInput(const char** data, const ExecType execType) override {
+        return Client::borrowInput(data, execType);
+    }
+
+    void consumeInput(const size_t size) override {
+        Client::consumeInput(size);
+    }
+};
+
+std::shared_ptr<Esp32Cli::Cli> cli;
+
+template<typename ClientType = StringClient>
+std::string execute(const std::string& input) {
+    const auto client = std::make_shared<ClientType>(cli);
+    client->execute(input);
+    return client->output;
+}
+
+template<typename ClientType>
+double megabytesPerSecond(const std::string& input, int repetitions) {
+    const auto client = std::make_shared<ClientType>(cli);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        client->execute(input);
+    }
+    const auto durationUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(input.size() * repetitions) / static_cast<double>(std::max<long long>(durationUs, 1));
+}
+
+const char* const ParserInputs[] = {
+    "echo a  b c;echo d\n",
+    "echo a\r\necho b\n\r",
+    "echo \"a b\" 'c\\'d' e\\\"f\n",
+    "echo x\\ty \\\nz\n",
+    "# echo comment ; echo no\necho a\n",
+    "echo 'unterminated\n",
+};
+}
+
+void setUp() {
+    cli = Esp32Cli::Cli::create("test");
+    cli->addCommand<EchoCommand>("echo");
+    cli->addCommand<CountCommand>("count");
+}
+
+void tearDown() {
+    cli.reset();
+}
+
+void test_splits_arguments_and_commands() {
+    TEST_ASSERT_EQUAL_STRING("a|b|c\nd\n", execute("echo a  b c;echo d\n").c_str());
+    TEST_ASSERT_EQUAL_STRING("a\nb\n", execute("echo a\r\necho b\n\r").c_str());
+}
+
+void test_quotes_escapes_and_comments() {
+    TEST_ASSERT_EQUAL_STRING("a b|c'd|e\"f\n", execute("echo \"a b\" 'c\\'d' e\\\"f\n").c_str());
+    TEST_ASSERT_EQUAL_STRING("x\ty|z\n", execute("echo x\\ty \\\nz\n").c_str());
+    TEST_ASSERT_EQUAL_STRING("a\n", execute("# echo comment ; echo no\necho a\n").c_str());
+}
+
+void test_argument_filling_the_buffer_followed_by_another_argument() {
+    // The terminator of the first argument takes the last byte of the buffer.
+    const std::string longArgument(Esp32Cli::Client::MaximumArgvSize - 1, 'a');
+    TEST_ASSERT_EQUAL_STRING((longArgument + ": argument list too long\n").c_str(),
+                             execute(longArgument + " b\n").c_str());
+
+    const std::string longEchoArgument(Esp32Cli::Client::MaximumArgvSize - sizeof("echo") - 1, 'a');
+    TEST_ASSERT_EQUAL_STRING("echo: argument list too long\nok\n",
+                             execute("echo " + longEchoArgument + " b \"c\" d\necho ok\n").c_str());
+}
+
+void test_too_many_arguments() {
+    std::string input = "echo";
+    for (size_t i = 0; i < Esp32Cli::Client::MaximumArgc; i++) {
+        input += " x";
+    }
+    TEST_ASSERT_EQUAL_STRING("echo: argument list too long\nok\n", execute(input + "\necho ok\n").c_str());
+}
+
+void test_bulk_and_single_byte_input_parse_the_same() {
+    for (const auto input : ParserInputs) {
+        TEST_ASSERT_EQUAL_STRING(execute<ByteStringClient>(input).c_str(), execute(input).c_str());
+    }
+    const std::string longArgument(Esp32Cli::Client::MaximumArgvSize - 1, 'a');
+    TEST_ASSERT_EQUAL_STRING(execute<ByteStringClient>(longArgument + " b\n").c_str(),
+                             execute(longArgument + " b\n").c_str());
+}
+
+void test_benchmark_bulk_and_single_byte_input() {
+    std::string input;
+    for (int i = 0; i < 100; i++) {
+        input += "count set \"a longer quoted argument\" 0x1234 [1.5,2,-3] 500/n\n";
+    }
+    constexpr int Repetitions = 200;
+    CountCommand::commandCount = 0;
+    const double singleByte = megabytesPerSecond<ByteStringClient>(input, Repetitions);
+    const double bulk = megabytesPerSecond<StringClient>(input, Repetitions);
+    TEST_ASSERT_EQUAL(2 * 100 * Repetitions, CountCommand::commandCount);
+
+    char message[96];
+    snprintf(message, sizeof(message), "single byte input %.1f MB/s, bulk input %.1f MB/s", singleByte, bulk);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_splits_arguments_and_commands);
+    RUN_TEST(test_quotes_escapes_and_comments);
+    RUN_TEST(test_argument_filling_the_buffer_followed_by_another_argument);
+    RUN_TEST(test_too_many_arguments);
+    RUN_TEST(test_bulk_and_single_byte_input_parse_the_same);
+    RUN_TEST(test_benchmark_bulk_and_single_byte_input);
+    return UNITY_END();
+}
@@ -0,0 +1,207 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Records commands with the trace and replays a trace dump through the host build, like replay-trace.sh does with a
+ * device. Set ESP32_CLI_TRACE to the file of a "trace dump" output to measure the replay throughput of a captured
+ * trace instead of the generated one.
+ */
+
+#include <Esp32Cli.h>
+#include <StringClient.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+namespace {
+class EchoCommand : public Esp32Cli::ArgvCommand {
+public:
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        for (size_t i = 1; i < argv.size(); i++) {
+            if (i > 1) {
+                io.print('|');
+            }
+            io.print(argv[i]);
+        }
+        io.print('\n');
+    }
+};
+
+/**
+ * Stands in for the device commands of a captured trace, which are not part of the host build.
+ */
+class NopCommand : public Esp32Cli::ArgvCommand {
+public:
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        executedCount++;
+    }
+
+    static size_t executedCount;
+};
+
+size_t NopCommand::executedCount = 0;
+
+std::shared_ptr<Esp32Cli::Cli> cli;
+
+std::string execute(const std::string& input) {
+    const auto client = std::make_shared<StringClient>(cli);
+    client->execute(input);
+    return client->output;
+}
+
+/**
+ * Extract the replayable command lines of a trace dump with the rules of replay-trace.sh.
+ */
+std::vector<std::string> parseTraceDump(std::istream& dump) {
+    std::vector<std::string> commandLines;
+    std::string line;
+    while (std::getline(dump, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        unsigned long startMs;
+        unsigned long durationUs;
+        unsigned clientId;
+        char truncated;
+        int commandLineOffset = -1;
+        if (sscanf(line.c_str(), "%lu %lu %u %c %n", &startMs, &durationUs, &clientId, &truncated,
+                   &commandLineOffset) < 4 || commandLineOffset < 0 || truncated == 'T') {
+            continue;
+        }
+        const std::string commandLine = line.substr(static_cast<size_t>(commandLineOffset));
+        if (commandLine == "trace" || commandLine.compare(0, 6, "trace ") == 0) {
+            continue;
+        }
+        commandLines.push_back(commandLine);
+    }
+    return commandLines;
+}
+
+std::string generatedTraceDump() {
+    const char* const commandLines[] = {
+        "led animate Base Blend 0.5 [100,200] =50 1 easeInOutQuad \"hsl(120, 100%, 50%)\"",
+        "led set 0-59 \"#ff8000\"",
+        "led brightness 0.8",
+        "ble metrics",
+        "kv get LedColor",
+    };
+    std::string dump;
+    char line[160];
+    for (unsigned i = 0; i < 1000; i++) {
+        snprintf(line, sizeof(line), "%u 250 1 - %s\n", i * 16, commandLines[i % 5]);
+        dump += line;
+    }
+    return dump;
+}
+}
+
+void setUp() {
+    cli = Esp32Cli::Cli::create("test");
+    cli->addCommand<EchoCommand>("echo");
+}
+
+void tearDown() {
+    cli.reset();
+}
+
+void test_replayed_dump_gives_the_same_output() {
+    const std::string input = "echo a b\necho \"quoted arg\" 'c\\'d' \"e\\\\f\"\necho \"\"\ntag 7 echo nested\n";
+    execute("trace on 16\n");
+    const std::string output = execute(input);
+    std::istringstream dump{execute("trace dump\n")};
+    execute("trace off\n");
+
+    const auto commandLines = parseTraceDump(dump);
+    TEST_ASSERT_EQUAL(4, commandLines.size());
+    TEST_ASSERT_TRUE(output.find("quoted arg|c'd|e\\f") != std::string::npos);
+    std::string replayInput;
+    for (const auto& commandLine: commandLines) {
+        replayInput += commandLine + "\n";
+    }
+    TEST_ASSERT_EQUAL_STRING(output.c_str(), execute(replayInput).c_str());
+}
+
+void test_truncated_commands_are_not_replayed() {
+    execute("trace on 4\n");
+    execute("echo " + std::string(Esp32Cli::CommandTrace::MaximumCommandLength, 'a') + "\necho short\n");
+    std::istringstream dump{execute("trace dump\n")};
+
+    const auto commandLines = parseTraceDump(dump);
+    TEST_ASSERT_EQUAL(1, commandLines.size());
+    TEST_ASSERT_EQUAL_STRING("echo short", commandLines[0].c_str());
+}
+
+void test_replay_throughput() {
+    const char* traceFile = getenv("ESP32_CLI_TRACE");
+    std::vector<std::string> commandLines;
+    if (traceFile != nullptr) {
+        std::ifstream dump{traceFile};
+        TEST_ASSERT_TRUE_MESSAGE(dump.good(), traceFile);
+        commandLines = parseTraceDump(dump);
+    } else {
+        std::istringstream dump{generatedTraceDump()};
+        commandLines = parseTraceDump(dump);
+    }
+
+    std::string replayInput;
+    for (const auto& commandLine: commandLines) {
+        replayInput += commandLine + "\n";
+        const std::string name = commandLine.substr(0, commandLine.find(' '));
+        bool isKnown = false;
+        for (const auto& entry: cli->getCommandEntries()) {
+            isKnown = isKnown || name == entry.first;
+        }
+        if (!isKnown) {
+            cli->addCommand<NopCommand>(name.c_str());
+        }
+    }
+    cli->freeze();
+
+    constexpr int Repetitions = 20;
+    NopCommand::executedCount = 0;
+    const auto client = std::make_shared<StringClient>(cli);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Repetitions; i++) {
+        client->execute(replayInput);
+    }
+    const auto durationUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (traceFile == nullptr) {
+        TEST_ASSERT_EQUAL(commandLines.size() * Repetitions, NopCommand::executedCount);
+    }
+
+    char message[128];
+    snprintf(message, sizeof(message), "%zu commands: %.0f commands/s, %.1f MB/s", commandLines.size(),
+             static_cast<double>(commandLines.size() * Repetitions) * 1e6 / static_cast<double>(std::max<long long>(durationUs, 1)),
+             static_cast<double>(replayInput.size() * Repetitions) / static_cast<double>(std::max<long long>(durationUs, 1)));
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_replayed_dump_gives_the_same_output);
+    RUN_TEST(test_truncated_commands_are_not_replayed);
+    RUN_TEST(test_replay_throughput);
+    return UNITY_END();
+}
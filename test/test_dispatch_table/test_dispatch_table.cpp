@@ -0,0 +1,161 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Esp32Cli.h>
+#include <Esp32Cli/CommandGroup.h>
+#include <Esp32Cli/DispatchTable.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+namespace {
+const char* const CommandNames[] = {
+    "animate", "ble", "brightness", "cat", "color", "credits", "df", "echo", "free", "help", "kv", "led", "ls",
+    "metrics", "mkdir", "mv", "ota", "ps", "reboot", "rm", "run", "script", "set", "sleep", "stat", "time", "trace",
+    "uptime", "version", "wifi", "z"
+};
+
+const char* const SubCommandNames[] = {
+    "add", "animate", "brightness", "clear", "config", "get", "list", "master", "off", "on", "set", "stop"
+};
+
+class NopCommand : public Esp32Cli::ArgvCommand {
+public:
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+    }
+};
+
+class TestGroup : public Esp32Cli::CommandGroup {
+public:
+    TestGroup() {
+        for (const auto name : SubCommandNames) {
+            addCommand<NopCommand>(name);
+        }
+    }
+
+    const Esp32Cli::Command* findSubCommand(const char* name) const {
+        return getCommand(name);
+    }
+};
+
+/**
+ * Command tree with the sorted map lookup the Cli used before the dispatch table.
+ */
+class TestContainer : public Esp32Cli::CommandContainer {
+public:
+    TestContainer() {
+        for (const auto name : CommandNames) {
+            if (strcmp(name, "led") == 0) {
+                addCommand<TestGroup>(name);
+            } else {
+                addCommand<NopCommand>(name);
+            }
+        }
+    }
+
+    const Esp32Cli::Command* findCommand(const char* name) const {
+        return getCommand(name);
+    }
+};
+
+template<typename Function>
+double nanosecondsPerLookup(Function function) {
+    constexpr int Iterations = 20000;
+    const auto start = std::chrono::steady_clock::now();
+    size_t lookups = 0;
+    for (int i = 0; i < Iterations; i++) {
+        lookups += function();
+    }
+    const auto durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(durationNs) / static_cast<double>(lookups);
+}
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_finds_the_same_commands_as_the_map() {
+    const TestContainer container;
+    const Esp32Cli::DispatchTable table{container};
+    for (const auto name : CommandNames) {
+        const auto index = table.find(Esp32Cli::DispatchTable::RootNode, name);
+        TEST_ASSERT_TRUE_MESSAGE(index != Esp32Cli::DispatchTable::InvalidNode, name);
+        TEST_ASSERT_TRUE_MESSAGE(table.node(index).command == container.findCommand(name), name);
+    }
+
+    const auto led = table.find(Esp32Cli::DispatchTable::RootNode, "led");
+    const auto* group = static_cast<const TestGroup*>(container.findCommand("led"));
+    for (const auto name : SubCommandNames) {
+        const auto index = table.find(led, name);
+        TEST_ASSERT_TRUE_MESSAGE(index != Esp32Cli::DispatchTable::InvalidNode, name);
+        TEST_ASSERT_TRUE_MESSAGE(table.node(index).command == group->findSubCommand(name), name);
+    }
+}
+
+void test_rejects_unknown_names() {
+    const TestContainer container;
+    const Esp32Cli::DispatchTable table{container};
+    for (const auto name : {"", "l", "le", "leds", "zz", "animat", "Led", "add"}) {
+        TEST_ASSERT_TRUE_MESSAGE(table.find(Esp32Cli::DispatchTable::RootNode, name) == Esp32Cli::DispatchTable::InvalidNode,
+                                 name);
+    }
+    const auto echo = table.find(Esp32Cli::DispatchTable::RootNode, "echo");
+    TEST_ASSERT_TRUE(table.find(echo, "add") == Esp32Cli::DispatchTable::InvalidNode);
+}
+
+void test_benchmark_lookup() {
+    const TestContainer container;
+    const Esp32Cli::DispatchTable table{container};
+    const Esp32Cli::Command* volatile sink = nullptr;
+
+    const double tableNs = nanosecondsPerLookup([&] {
+        for (const auto name : CommandNames) {
+            // Read through volatile, so the lookup is not hoisted out of the benchmark loop.
+            const char* volatile argument = name;
+            sink = table.node(table.find(Esp32Cli::DispatchTable::RootNode, argument)).command;
+        }
+        return sizeof(CommandNames) / sizeof(CommandNames[0]);
+    });
+    const double mapNs = nanosecondsPerLookup([&] {
+        for (const auto name : CommandNames) {
+            const char* volatile argument = name;
+            sink = container.findCommand(argument);
+        }
+        return sizeof(CommandNames) / sizeof(CommandNames[0]);
+    });
+
+    char message[96];
+    snprintf(message, sizeof(message), "%zu commands: dispatch table %.1f ns, sorted map %.1f ns per lookup",
+             sizeof(CommandNames) / sizeof(CommandNames[0]), tableNs, mapNs);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_finds_the_same_commands_as_the_map);
+    RUN_TEST(test_rejects_unknown_names);
+    RUN_TEST(test_benchmark_lookup);
+    return UNITY_END();
+}
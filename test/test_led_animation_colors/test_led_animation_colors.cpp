@@ -0,0 +1,136 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Led/Animation.h>
+#include <Led/HslwColor.h>
+
+#include <chrono>
+#include <cstdio>
+#include <unity.h>
+#include <vector>
+
+namespace {
+constexpr size_t AnimationCount = 24;
+constexpr Led::Led::index_t LedCount = 300;
+constexpr int FrameCount = 2000;
+
+using Duration = Led::Animation::duration;
+
+/**
+ * The animations of a frame, once with the configured HSL colors and once with the colors converted when the
+ * animation was added.
+ */
+struct Frame {
+    std::vector<Led::HslwColor> hslTargetColors;
+    std::vector<Led::Animation> animations;
+    std::vector<RgbwColor> colorBuffer = std::vector<RgbwColor>(LedCount);
+};
+
+Frame createFrame(size_t ledsPerAnimation) {
+    Frame frame;
+    for (size_t i = 0; i < AnimationCount; i++) {
+        const Led::HslwColor hslColor{HslColor{static_cast<float>(i) / AnimationCount, 1.f, 0.5f}, 0, 0.8f};
+        frame.hslTargetColors.push_back(hslColor);
+
+        Led::Animation animation{};
+        animation.blending = Led::Blending::Blend;
+        animation.easing = Easing::easeInOutQuad;
+        animation.targetColor = hslColor.toRgbwColor();
+        animation.halfCycles = 2;
+        for (size_t led = 0; led < ledsPerAnimation; led++) {
+            animation.leds.emplace_back((i * 7 + led) % LedCount, Duration{100}, Duration{static_cast<uint16_t>(led)},
+                                        65535);
+        }
+        frame.animations.push_back(std::move(animation));
+    }
+    return frame;
+}
+
+/**
+ * The per LED part of LedString::update(), with the target color either converted every frame or read as stored.
+ */
+template<bool ConvertEveryFrame>
+void renderFrame(Frame& frame, int frameIndex) {
+    for (size_t a = 0; a < frame.animations.size(); a++) {
+        const auto& animation = frame.animations[a];
+        const RgbwColor targetColor = ConvertEveryFrame ? frame.hslTargetColors[a].toRgbwColor() : animation.targetColor;
+        for (const auto& led: animation.leds) {
+            const int timeRunning = frameIndex - led.ledDelay.count();
+            if (timeRunning < 0) {
+                continue;
+            }
+            float animationProgress = std::min(1.f, static_cast<float>(timeRunning % 200) / led.ledDuration.count());
+            animationProgress *= static_cast<float>(animation.halfCycles);
+            const int animationCycle = static_cast<int>(animationProgress);
+            animationProgress -= static_cast<float>(animationCycle);
+            if (animationCycle % 2) {
+                animationProgress = 1 - animationProgress;
+            }
+            const float blendValue = animation.easing(animationProgress) *
+                                     (static_cast<float>(led.ledBrightnessFactor) / 65535.f);
+            auto& ledColor = frame.colorBuffer[led.ledIndex];
+            ledColor = RgbwColor::LinearBlend(ledColor, targetColor, blendValue);
+        }
+    }
+}
+
+template<bool ConvertEveryFrame>
+double microsecondsPerFrame(Frame& frame) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FrameCount; i++) {
+        renderFrame<ConvertEveryFrame>(frame, i);
+    }
+    const auto durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(durationNs) / FrameCount / 1000;
+}
+
+void benchmark(size_t ledsPerAnimation) {
+    Frame hslFrame = createFrame(ledsPerAnimation);
+    Frame rgbwFrame = createFrame(ledsPerAnimation);
+    const double hslUs = microsecondsPerFrame<true>(hslFrame);
+    const double rgbwUs = microsecondsPerFrame<false>(rgbwFrame);
+    TEST_ASSERT_TRUE(hslFrame.colorBuffer == rgbwFrame.colorBuffer);
+
+    char message[128];
+    snprintf(message, sizeof(message), "%zu animations x %zu LEDs: HSL per frame %.2f us, stored RGBW %.2f us",
+             AnimationCount, ledsPerAnimation, hslUs, rgbwUs);
+    TEST_MESSAGE(message);
+}
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_benchmark_single_led_animations() {
+    benchmark(1);
+}
+
+void test_benchmark_wide_animations() {
+    benchmark(30);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_benchmark_single_led_animations);
+    RUN_TEST(test_benchmark_wide_animations);
+    return UNITY_END();
+}
@@ -0,0 +1,227 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <LedStrUtils.h>
+
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unity.h>
+
+namespace {
+const char* const UlongInputs[] = {
+    "", " ", " \t\n\r\v\f", "0", "42", "  42", "42  ", "+42", "-1", "-42", " - 1", "+", "-", "0x1f", "0X1F", "-0x10",
+    "0x", "0xg", "010", "08", "09", "12abc", "1s", "500/n", "abc", "4294967295", "4294967296", "18446744073709551615",
+    "18446744073709551616", "99999999999999999999999", "-99999999999999999999", "0xffffffffffffffff",
+    "0x1ffffffffffffffff", "0777777777777777777777", "02000000000000000000000"
+};
+
+const char* const FloatInputs[] = {
+    "", " ", " \t\n", "0", "-0", "+0", "1", "-1.5", "+2.25", "  3.125  ", ".5", "-.5", "5.", ".", "-", "+", "-.",
+    "1e3", "1E-3", "2.5e+2", "1e", "1e+", "1e-", ".e5", "e5", "12.34.56", "1,2", "0.000001", "123456.789",
+    "1e38", "1e-37", "1e50", "-1e50", "1e-50", "00000001.50000000"
+};
+
+struct UlongResult {
+    unsigned long value;
+    size_t length;
+};
+
+struct FloatResult {
+    float value;
+    size_t length;
+};
+
+UlongResult parseUlong(const std::string& input) {
+    // Followed by a digit that must not be parsed, so reads past end are noticed.
+    const std::string buffer = input + "7";
+    const char* parsedEnd = nullptr;
+    const auto value = parse_ulong(buffer.data(), buffer.data() + input.size(), &parsedEnd);
+    return {value, static_cast<size_t>(parsedEnd - buffer.data())};
+}
+
+UlongResult strtoulReference(const std::string& input) {
+    char* parsedEnd = nullptr;
+    const auto value = strtoul(input.c_str(), &parsedEnd, 0);
+    return {value, static_cast<size_t>(parsedEnd - input.c_str())};
+}
+
+FloatResult parseFloat(const std::string& input) {
+    const std::string buffer = input + "7";
+    const char* parsedEnd = nullptr;
+    const auto value = parse_float(buffer.data(), buffer.data() + input.size(), &parsedEnd);
+    return {value, static_cast<size_t>(parsedEnd - buffer.data())};
+}
+
+FloatResult strtofReference(const std::string& input) {
+    char* parsedEnd = nullptr;
+    const auto value = strtof(input.c_str(), &parsedEnd);
+    return {value, static_cast<size_t>(parsedEnd - input.c_str())};
+}
+
+/**
+ * parse_float accumulates digits in float, so it may be a few ULP off. Values below FLT_MIN are denormal and only
+ * compared absolutely.
+ */
+bool isClose(float a, float b) {
+    if (std::isinf(a) || std::isinf(b)) {
+        return a == b;
+    }
+    return std::fabs(a - b) <= 1e-5f * std::max(std::fabs(a), std::fabs(b)) + FLT_MIN;
+}
+
+void checkUlong(const std::string& input) {
+    const auto result = parseUlong(input);
+    const auto expected = strtoulReference(input);
+    char message[160];
+    snprintf(message, sizeof(message), "\"%s\": %lu (%zu chars) expected %lu (%zu chars)", input.c_str(),
+             result.value, result.length, expected.value, expected.length);
+    TEST_ASSERT_TRUE_MESSAGE(result.value == expected.value && result.length == expected.length, message);
+}
+
+void checkFloat(const std::string& input) {
+    const auto result = parseFloat(input);
+    const auto expected = strtofReference(input);
+    char message[160];
+    snprintf(message, sizeof(message), "\"%s\": %g (%zu chars) expected %g (%zu chars)", input.c_str(),
+             result.value, result.length, expected.value, expected.length);
+    TEST_ASSERT_TRUE_MESSAGE(isClose(result.value, expected.value) && result.length == expected.length, message);
+}
+
+std::string randomString(std::mt19937& random, const std::string& alphabet, size_t maximumLength) {
+    std::string str(random() % (maximumLength + 1), ' ');
+    for (auto& c : str) {
+        c = alphabet[random() % alphabet.size()];
+    }
+    return str;
+}
+
+template<typename Function>
+double nanosecondsPerCall(Function function) {
+    constexpr int Iterations = 200000;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++) {
+        function(i);
+    }
+    const auto durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(durationNs) / Iterations;
+}
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_parse_ulong_matches_strtoul() {
+    for (const auto input : UlongInputs) {
+        checkUlong(input);
+    }
+}
+
+void test_parse_ulong_fuzz() {
+    std::mt19937 random{1};
+    for (int i = 0; i < 100000; i++) {
+        checkUlong(randomString(random, " \t+-0123456789xXabcdefgABCDEFG", 24));
+    }
+}
+
+void test_parse_float_matches_strtof() {
+    for (const auto input : FloatInputs) {
+        checkFloat(input);
+    }
+}
+
+void test_parse_float_fuzz() {
+    std::mt19937 random{2};
+    // Without exponents: Any syntax, including long mantissas.
+    for (int i = 0; i < 100000; i++) {
+        checkFloat(randomString(random, " \t+-0123456789.a", 16));
+    }
+    // With exponents: Short mantissas, so float accumulation stays within the tolerance.
+    for (int i = 0; i < 100000; i++) {
+        checkFloat(randomString(random, " +-0123456789.eE", 8));
+    }
+}
+
+void test_trim_matches_string_trim() {
+    std::mt19937 random{3};
+    for (int i = 0; i < 10000; i++) {
+        const auto input = randomString(random, " \t\n\r\v\fa[]", 12);
+
+        auto expected = input;
+        trim(expected);
+        const char* begin = input.data();
+        const char* end = begin + input.size();
+        trim(begin, end);
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), std::string(begin, end).c_str());
+
+        expected = input;
+        trim(expected, '[');
+        begin = input.data();
+        end = begin + input.size();
+        trim(begin, end, '[');
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), std::string(begin, end).c_str());
+    }
+}
+
+void test_benchmark() {
+    // Ranges inside a larger string as in "[10,250]" or "1.5,2,-3", which previously were copied out.
+    const std::string durations = "[1500,0x20]";
+    const std::string positions = "1.25,-0.5,3";
+    volatile unsigned long ulongSink = 0;
+    volatile float floatSink = 0;
+
+    const double strtoulNs = nanosecondsPerCall([&](int i) {
+        ulongSink = ulongSink + strtoul(durations.substr(1 + (i & 1) * 5, 4).c_str(), nullptr, 0);
+    });
+    const double parseUlongNs = nanosecondsPerCall([&](int i) {
+        const char* begin = durations.data() + 1 + (i & 1) * 5;
+        ulongSink = ulongSink + parse_ulong(begin, begin + 4);
+    });
+    const double strtofNs = nanosecondsPerCall([&](int i) {
+        floatSink = floatSink + strtof(positions.substr((i & 1) * 5, 4).c_str(), nullptr);
+    });
+    const double parseFloatNs = nanosecondsPerCall([&](int i) {
+        const char* begin = positions.data() + (i & 1) * 5;
+        floatSink = floatSink + parse_float(begin, begin + 4);
+    });
+
+    char message[128];
+    snprintf(message, sizeof(message), "substr+strtoul %.1f ns, parse_ulong %.1f ns", strtoulNs, parseUlongNs);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message), "substr+strtof %.1f ns, parse_float %.1f ns", strtofNs, parseFloatNs);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_ulong_matches_strtoul);
+    RUN_TEST(test_parse_ulong_fuzz);
+    RUN_TEST(test_parse_float_matches_strtof);
+    RUN_TEST(test_parse_float_fuzz);
+    RUN_TEST(test_trim_matches_string_trim);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <RingBuffer.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <unity.h>
+
+namespace {
+constexpr size_t StressValueCount = 1 << 22;
+
+using StressBuffer = RingBuffer<uint32_t, 256>;
+
+/**
+ * Write an increasing sequence, alternating between push and writeSpan/commitWrite with varying chunk sizes.
+ */
+void produce(StressBuffer& buffer, const size_t valueCount) {
+    uint32_t next = 0;
+    uint32_t chunk[37];
+    size_t round = 0;
+    while (next < valueCount) {
+        const size_t chunkSize = std::min<size_t>(1 + round % 37, valueCount - next);
+        if (round++ % 2) {
+            for (size_t i = 0; i < chunkSize; i++) {
+                chunk[i] = next + i;
+            }
+            const size_t pushed = buffer.push(chunk, chunkSize);
+            if (pushed == 0) {
+                std::this_thread::yield();
+            }
+            next += pushed;
+        } else {
+            size_t spanSize;
+            uint32_t* span = buffer.writeSpan(&spanSize);
+            spanSize = std::min(spanSize, chunkSize);
+            for (size_t i = 0; i < spanSize; i++) {
+                span[i] = next + i;
+            }
+            if (spanSize == 0) {
+                std::this_thread::yield();
+            }
+            buffer.commitWrite(spanSize);
+            next += spanSize;
+        }
+    }
+}
+
+/**
+ * Read the sequence back, alternating between read and readSpan/pop.
+ * @return Number of values received in order before the first mismatch.
+ */
+size_t consume(StressBuffer& buffer, const size_t valueCount) {
+    uint32_t expected = 0;
+    uint32_t chunk[53];
+    size_t round = 0;
+    while (expected < valueCount) {
+        if (round++ % 2) {
+            const size_t readSize = buffer.read(chunk, 1 + round % 53);
+            if (readSize == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < readSize; i++) {
+                if (chunk[i] != expected++) {
+                    return expected - 1;
+                }
+            }
+        } else {
+            size_t spanSize;
+            const uint32_t* span = buffer.readSpan(&spanSize);
+            if (spanSize == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < spanSize; i++) {
+                if (span[i] != expected++) {
+                    return expected - 1;
+                }
+            }
+            TEST_ASSERT_TRUE(buffer.pop(spanSize));
+        }
+    }
+    return expected;
+}
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_push_and_read_wrap_around() {
+    RingBuffer<uint8_t, 8> buffer;
+    const uint8_t values[] = {1, 2, 3, 4, 5, 6};
+    uint8_t output[8];
+
+    TEST_ASSERT_EQUAL(6, buffer.push(values, 6));
+    TEST_ASSERT_EQUAL(4, buffer.read(output, 4));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(values, output, 4);
+
+    // Wraps around the end of the storage and stops when full.
+    TEST_ASSERT_EQUAL(6, buffer.push(values, 6));
+    TEST_ASSERT_EQUAL(0, buffer.free());
+    TEST_ASSERT_EQUAL(0, buffer.push(values, 1));
+
+    size_t spanSize;
+    buffer.readSpan(&spanSize);
+    TEST_ASSERT_EQUAL(4, spanSize);
+    TEST_ASSERT_EQUAL(8, buffer.read(output, 8));
+    const uint8_t expected[] = {5, 6, 1, 2, 3, 4, 5, 6};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, output, 8);
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_FALSE(buffer.pop(1));
+}
+
+void test_write_span_is_contiguous() {
+    RingBuffer<uint8_t, 8> buffer;
+    const uint8_t values[] = {1, 2, 3, 4, 5};
+    uint8_t output[8];
+    buffer.push(values, 5);
+    buffer.read(output, 3);
+
+    size_t spanSize;
+    uint8_t* span = buffer.writeSpan(&spanSize);
+    TEST_ASSERT_EQUAL(3, spanSize);
+    span[0] = 6;
+    buffer.commitWrite(1);
+    TEST_ASSERT_EQUAL(3, buffer.available());
+
+    buffer.clear();
+    buffer.writeSpan(&spanSize);
+    TEST_ASSERT_EQUAL(8, spanSize);
+}
+
+void test_concurrent_producer_and_consumer() {
+    StressBuffer buffer;
+    std::thread producer{[&buffer] {
+        produce(buffer, StressValueCount);
+    }};
+    const size_t received = consume(buffer, StressValueCount);
+    producer.join();
+    TEST_ASSERT_EQUAL(StressValueCount, received);
+    TEST_ASSERT_TRUE(buffer.empty());
+}
+
+void test_throughput() {
+    StressBuffer buffer;
+    const auto start = std::chrono::steady_clock::now();
+    std::thread producer{[&buffer] {
+        produce(buffer, StressValueCount);
+    }};
+    consume(buffer, StressValueCount);
+    producer.join();
+    const auto durationUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    char message[64];
+    snprintf(message, sizeof(message), "%.1f MB/s",
+             static_cast<double>(StressValueCount * sizeof(uint32_t)) / static_cast<double>(std::max<long long>(durationUs, 1)));
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_and_read_wrap_around);
+    RUN_TEST(test_write_span_is_contiguous);
+    RUN_TEST(test_concurrent_producer_and_consumer);
+    RUN_TEST(test_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,179 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Output of TelnetAwareClient over a loopback TCP connection with TCP_NODELAY, like the telnet server sets up its
+ * sessions.
+ */
+
+#include <Esp32Cli.h>
+#include <Esp32Cli/TelnetAwareClient.h>
+#include <WiFi.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unity.h>
+
+namespace {
+/**
+ * Like the test-data command of the firmware: Sends the requested number of bytes in writes of 8 bytes.
+ */
+class TestDataCommand : public Esp32Cli::Command {
+public:
+    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        size_t size = strtoul(argv[1].c_str(), nullptr, 0);
+        while (size > 0) {
+            size -= io.write("12345678", std::min<size_t>(size, 8));
+        }
+    }
+};
+
+/**
+ * Prints the requested number of lines of 32 bytes including the line break, like listings and file output.
+ */
+class LinesCommand : public Esp32Cli::Command {
+public:
+    void execute(Stream& io, const std::string& commandName, std::vector<std::string>& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        const size_t count = strtoul(argv[1].c_str(), nullptr, 0);
+        for (size_t i = 0; i < count; i++) {
+            io.printf("line %08zu abcdefghijklmnopq\n", i);
+        }
+    }
+};
+
+struct Connection {
+    std::shared_ptr<Esp32Cli::TelnetAwareClient> client;
+    int peerFd;
+};
+
+std::shared_ptr<Esp32Cli::Cli> cli;
+
+Connection connect() {
+    const int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressLength = sizeof(address);
+    TEST_ASSERT_TRUE(bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    TEST_ASSERT_TRUE(listen(listenFd, 1) == 0);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &addressLength);
+
+    const int peerFd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT_TRUE(connect(peerFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    const int fd = accept(listenFd, nullptr, nullptr);
+    close(listenFd);
+    TEST_ASSERT_TRUE(fd >= 0);
+
+    std::unique_ptr<WiFiClient> wiFiClient(new WiFiClient(fd));
+    wiFiClient->setNoDelay(true);
+    return {std::make_shared<Esp32Cli::TelnetAwareClient>(cli, std::move(wiFiClient)), peerFd};
+}
+
+/**
+ * Send the command line from the peer and let the client execute it.
+ */
+void execute(const Connection& connection, const std::string& commandLine) {
+    TEST_ASSERT_EQUAL(commandLine.size(), send(connection.peerFd, commandLine.data(), commandLine.size(), 0));
+    while (connection.client->hasPendingInput()) {
+        connection.client->executeCommandLine(Esp32Cli::Client::ExecType::NonBlocking);
+    }
+}
+
+/**
+ * Receive on the peer until the output ends with the prompt.
+ */
+std::string receiveUntilPrompt(const Connection& connection) {
+    std::string output;
+    char buffer[4096];
+    while (output.size() < 2 || output.compare(output.size() - 2, 2, "> ") != 0) {
+        const ssize_t size = recv(connection.peerFd, buffer, sizeof(buffer), 0);
+        if (size <= 0) {
+            break;
+        }
+        output.append(buffer, static_cast<size_t>(size));
+    }
+    return output;
+}
+
+void benchmark(const char* name, const std::string& commandLine, size_t minimumSize) {
+    const auto connection = connect();
+    const auto start = std::chrono::steady_clock::now();
+    std::thread executor{[&connection, &commandLine] {
+        execute(connection, commandLine);
+    }};
+    const auto output = receiveUntilPrompt(connection);
+    const auto durationUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    executor.join();
+    close(connection.peerFd);
+    TEST_ASSERT_GREATER_THAN(minimumSize, output.size());
+
+    char message[96];
+    snprintf(message, sizeof(message), "%s: %zu bytes, %.1f MB/s", name, output.size(),
+             static_cast<double>(output.size()) / static_cast<double>(std::max<long long>(durationUs, 1)));
+    TEST_MESSAGE(message);
+}
+}
+
+void setUp() {
+    cli = Esp32Cli::Cli::create("test");
+    cli->addCommand<TestDataCommand>("test-data");
+    cli->addCommand<LinesCommand>("lines");
+}
+
+void tearDown() {
+    cli.reset();
+}
+
+void test_translates_line_breaks() {
+    const auto connection = connect();
+    execute(connection, "lines 3\n");
+    const auto output = receiveUntilPrompt(connection);
+    close(connection.peerFd);
+    TEST_ASSERT_EQUAL_STRING("\r\n"
+                             "line 00000000 abcdefghijklmnopq\r\n"
+                             "line 00000001 abcdefghijklmnopq\r\n"
+                             "line 00000002 abcdefghijklmnopq\r\n"
+                             "test> ", output.c_str());
+}
+
+void test_sends_output_larger_than_the_buffer() {
+    const auto connection = connect();
+    execute(connection, "test-data 100000\n");
+    const auto output = receiveUntilPrompt(connection);
+    close(connection.peerFd);
+    TEST_ASSERT_EQUAL(2 + 100000 + 6, output.size());
+}
+
+void test_benchmark_test_data() {
+    benchmark("test-data 1 MiB in 8 byte writes", "test-data 1048576\n", 1048576);
+}
+
+void test_benchmark_lines() {
+    benchmark("32768 lines", "lines 32768\n", 32768 * 33);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_translates_line_breaks);
+    RUN_TEST(test_sends_output_larger_than_the_buffer);
+    RUN_TEST(test_benchmark_test_data);
+    RUN_TEST(test_benchmark_lines);
+    return UNITY_END();
+}
@@ -0,0 +1,196 @@
+/*
+ * Part of Esp32BleControl a firmware to allow ESP32 remote control over BLE.
+ * Copyright (C) 2024  Simon Fischer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * TelnetServer on a local port with plain TCP clients in place of telnet clients.
+ */
+
+#include <Esp32Cli.h>
+#include <Esp32Cli/TelnetServer.h>
+
+#include <string>
+#include <unity.h>
+#include <vector>
+
+namespace {
+constexpr uint16_t Port = 42323;
+
+class EchoCommand : public Esp32Cli::ArgvCommand {
+public:
+    void execute(Stream& io, const Esp32Cli::ArgvView& argv, const std::shared_ptr<Esp32Cli::Client>& client) const override {
+        for (size_t i = 1; i < argv.size(); i++) {
+            if (i > 1) {
+                io.print(' ');
+            }
+            io.print(argv[i]);
+        }
+        io.print('\n');
+    }
+};
+
+std::shared_ptr<Esp32Cli::Cli> cli;
+std::unique_ptr<Esp32Cli::TelnetServer> server;
+
+int connectToServer() {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(Port);
+    TEST_ASSERT_TRUE(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    timeval timeout{2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+void sendLine(const int fd, const std::string& line) {
+    TEST_ASSERT_EQUAL(line.size(), send(fd, line.data(), line.size(), 0));
+}
+
+/**
+ * Receive until the output ends with the given string, the connection is closed or nothing arrives for 2 s.
+ */
+std::string receiveUntil(const int fd, const std::string& ending) {
+    std::string output;
+    char buffer[256];
+    while (output.size() < ending.size() || output.compare(output.size() - ending.size(), ending.size(), ending) != 0) {
+        const ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        if (size <= 0) {
+            break;
+        }
+        output.append(buffer, static_cast<size_t>(size));
+    }
+    return output;
+}
+
+bool isClosedByServer(const int fd) {
+    char value;
+    return recv(fd, &value, 1, 0) == 0;
+}
+
+/**
+ * Stats are updated by the listen task, wait for it to catch up.
+ */
+template<typename Predicate>
+bool waitForStats(Predicate predicate) {
+    for (int i = 0; i < 100; i++) {
+        if (predicate(server->getStats())) {
+            return true;
+        }
+        delay(10);
+    }
+    return false;
+}
+}
+
+void setUp() {
+    cli = Esp32Cli::Cli::create("test");
+    cli->addCommand<EchoCommand>("echo");
+    server.reset(new Esp32Cli::TelnetServer{cli, Port});
+}
+
+void tearDown() {
+    server.reset();
+    cli.reset();
+}
+
+void test_serves_several_sessions() {
+    std::vector<int> fds;
+    for (size_t i = 0; i < Esp32Cli::TelnetServer::MaximumClients; i++) {
+        fds.push_back(connectToServer());
+    }
+    for (size_t i = 0; i < fds.size(); i++) {
+        sendLine(fds[i], "echo session " + std::to_string(i) + "\n");
+    }
+    for (size_t i = 0; i < fds.size(); i++) {
+        const std::string expected = "\r\nsession " + std::to_string(i) + "\r\ntest> ";
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), receiveUntil(fds[i], "> ").c_str());
+    }
+    // A session keeps working after its first command.
+    sendLine(fds[0], "echo again\n");
+    TEST_ASSERT_EQUAL_STRING("\r\nagain\r\ntest> ", receiveUntil(fds[0], "> ").c_str());
+    for (const int fd: fds) {
+        close(fd);
+    }
+}
+
+void test_rejects_sessions_beyond_the_maximum() {
+    std::vector<int> fds;
+    for (size_t i = 0; i < Esp32Cli::TelnetServer::MaximumClients; i++) {
+        fds.push_back(connectToServer());
+    }
+    TEST_ASSERT_TRUE(waitForStats([](const Esp32Cli::TelnetServer::Stats& stats) {
+        return stats.activeConnections == Esp32Cli::TelnetServer::MaximumClients;
+    }));
+
+    const int rejectedFd = connectToServer();
+    TEST_ASSERT_EQUAL_STRING("Too many connections\r\n", receiveUntil(rejectedFd, "\r\n").c_str());
+    TEST_ASSERT_TRUE(isClosedByServer(rejectedFd));
+    close(rejectedFd);
+
+    const auto stats = server->getStats();
+    TEST_ASSERT_EQUAL(Esp32Cli::TelnetServer::MaximumClients, stats.acceptedConnections);
+    TEST_ASSERT_EQUAL(1, stats.rejectedConnections);
+    for (const int fd: fds) {
+        close(fd);
+    }
+}
+
+void test_removes_closed_sessions_and_keeps_their_traffic() {
+    const int fd = connectToServer();
+    const std::string commandLine = "echo bytes\n";
+    sendLine(fd, commandLine);
+    receiveUntil(fd, "> ");
+    close(fd);
+
+    TEST_ASSERT_TRUE(waitForStats([&commandLine](const Esp32Cli::TelnetServer::Stats& stats) {
+        return stats.activeConnections == 0 && stats.bytesReceived == commandLine.size();
+    }));
+    // The command output and the prompt, without the line break echo.
+    TEST_ASSERT_EQUAL(sizeof("bytes\r\ntest> ") - 1, server->getStats().bytesSent);
+
+    // The slot of the closed session is free again.
+    const int nextFd = connectToServer();
+    sendLine(nextFd, "echo next\n");
+    TEST_ASSERT_EQUAL_STRING("\r\nnext\r\ntest> ", receiveUntil(nextFd, "> ").c_str());
+    close(nextFd);
+}
+
+void test_end_of_transmission_closes_the_session() {
+    const int fd = connectToServer();
+    sendLine(fd, "\x04");
+    TEST_ASSERT_TRUE(isClosedByServer(fd));
+    close(fd);
+    TEST_ASSERT_TRUE(waitForStats([](const Esp32Cli::TelnetServer::Stats& stats) {
+        return stats.activeConnections == 0;
+    }));
+
+    const int nextFd = connectToServer();
+    sendLine(nextFd, "echo next\n");
+    TEST_ASSERT_EQUAL_STRING("\r\nnext\r\ntest> ", receiveUntil(nextFd, "> ").c_str());
+    close(nextFd);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_serves_several_sessions);
+    RUN_TEST(test_rejects_sessions_beyond_the_maximum);
+    RUN_TEST(test_removes_closed_sessions_and_keeps_their_traffic);
+    RUN_TEST(test_end_of_transmission_closes_the_session);
+    return UNITY_END();
+}